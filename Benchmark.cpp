@@ -0,0 +1,218 @@
+#include "Benchmark.h"
+#include "Solver.h"
+#include "EndgameSolver.h"
+#include "ConfigSampler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <algorithm>
+
+struct BenchmarkPreset {
+  const char* name;
+  int height;
+  int width;
+  int mines;
+};
+
+static const BenchmarkPreset benchmarkPresets[] = {
+  { "beginner", 9, 9, 10 },
+  { "intermediate", 16, 16, 40 },
+  { "expert", 16, 30, 99 },
+};
+
+// Fraction of the safe cells revealed at each stage
+static const std::pair<const char*, double> benchmarkStages[] = {
+  { "opening", 0.0 },
+  { "early", 0.25 },
+  { "mid", 0.5 },
+  { "late", 0.8 },
+};
+
+// Places the mines away from the first click, opens it, then keeps revealing random
+// safe cells next to the revealed area until the given fraction of safe cells is
+// revealed, like a player working along the frontier would.
+static vector<vector<int>> generateBoard(const BenchmarkPreset& preset, double revealed, std::mt19937& rng) {
+  int h = preset.height;
+  int w = preset.width;
+  vector<vector<int>> mine(h, vector<int>(w, 0));
+  int sr = rng() % h;
+  int sc = rng() % w;
+  for (int placed = 0; placed < preset.mines;) {
+    int r = rng() % h;
+    int c = rng() % w;
+    if (mine[r][c] || (abs(r - sr) <= 1 && abs(c - sc) <= 1))
+      continue;
+    mine[r][c] = 1;
+    placed += 1;
+  }
+
+  vector<vector<int>> rd(h, vector<int>(w, CELL_UNDISCOVERED));
+  int nRevealed = 0;
+  vector<std::pair<int, int>> stack;
+  auto reveal = [&](int r0, int c0) {
+    stack.push_back({ r0, c0 });
+    while (!stack.empty()) {
+      auto [r, c] = stack.back();
+      stack.pop_back();
+      if (rd[r][c] != CELL_UNDISCOVERED || mine[r][c])
+        continue;
+
+      int n = 0;
+      for (int i = max(r - 1, 0); i <= min(r + 1, h - 1); ++i) {
+        for (int j = max(c - 1, 0); j <= min(c + 1, w - 1); ++j)
+          n += mine[i][j];
+      }
+      rd[r][c] = n;
+      nRevealed += 1;
+      if (n != 0)
+        continue;
+      for (int i = max(r - 1, 0); i <= min(r + 1, h - 1); ++i) {
+        for (int j = max(c - 1, 0); j <= min(c + 1, w - 1); ++j)
+          stack.push_back({ i, j });
+      }
+    }
+  };
+  reveal(sr, sc);
+
+  int target = (int) (revealed * (h * w - preset.mines));
+  while (nRevealed < target) {
+    vector<std::pair<int, int>> frontier;
+    for (int r = 0; r < h; ++r) {
+      for (int c = 0; c < w; ++c) {
+        if (rd[r][c] != CELL_UNDISCOVERED || mine[r][c])
+          continue;
+        bool adjacent = false;
+        for (int i = max(r - 1, 0); i <= min(r + 1, h - 1); ++i) {
+          for (int j = max(c - 1, 0); j <= min(c + 1, w - 1); ++j)
+            adjacent |= rd[i][j] >= 0;
+        }
+        if (adjacent)
+          frontier.push_back({ r, c });
+      }
+    }
+    if (frontier.empty())
+      break;
+    auto [r, c] = frontier[rng() % frontier.size()];
+    reveal(r, c);
+  }
+  return rd;
+}
+
+vector<BenchmarkBoard> generateBenchmarkCorpus(unsigned seed, int boardsPerStage) {
+  std::mt19937 rng(seed);
+  vector<BenchmarkBoard> corpus;
+  for (const BenchmarkPreset& preset : benchmarkPresets) {
+    for (const auto& [stage, revealed] : benchmarkStages) {
+      for (int i = 0; i < boardsPerStage; ++i)
+        corpus.push_back({ preset.name, stage, generateBoard(preset, revealed, rng), preset.mines });
+    }
+  }
+  return corpus;
+}
+
+// Timings of every phase in microseconds, per "preset/stage" and phase name.
+typedef std::map<string, std::map<string, vector<double>>> BenchmarkTimings;
+
+template <typename F>
+static double timeUs(F&& f) {
+  auto t0 = std::chrono::steady_clock::now();
+  f();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t1 - t0).count();
+}
+
+// Runs the phases of a full solve one after the other on a single board, the same
+// way generalSolve() and tryWarp() chain them, then times generalSolve() as a whole
+// on a fresh solver of the same board. The chain cache starts empty for every board,
+// and a second generalSolve() on another fresh solver gives the time with every
+// chain found in the cache.
+static void benchmarkBoard(const BenchmarkBoard& board, std::map<string, vector<double>>& timings, std::mt19937& rng) {
+  Solver::ChainCache::shared().clear();
+  Solver solver(board.rd);
+  if (!solver.valid_input)
+    return;
+
+  bool valid = true;
+  timings["iterativeSolve"].push_back(timeUs([&] { valid = solver.iterativeSolve(); }));
+  if (!valid)
+    return;
+
+  int mines = board.mines;
+  for (Cell* c : solver.solvedCells)
+    mines -= (c->minePerc == 100.f);
+
+  Solver::SolveContext ctx;
+  vector<vector<Group*>> chains = solver.getGroupChains();
+  for (const vector<Group*>& chain : chains) {
+    timings["solveChain"].push_back(timeUs([&] { ctx.chain_sols.push_back(solver.solveChain(chain)); }));
+    timings["countChain"].push_back(timeUs([&] { solver.countChain(chain); }));
+  }
+  timings["combineChainMineCount"].push_back(timeUs([&] { valid = solver.weighChains(mines, ctx); }));
+  if (!valid)
+    return;
+
+  Solver full(board.rd);
+  timings["generalSolve"].push_back(timeUs([&] { valid = full.generalSolve(board.mines); }));
+  if (!valid)
+    return;
+  Solver warm(board.rd);
+  timings["generalSolve (cached chains)"].push_back(timeUs([&] { warm.generalSolve(board.mines); }));
+
+  vector<vector<int>> mineConf;
+  timings["sampleConfiguration"].push_back(timeUs([&] {
+    Solver::sampleConfiguration(full, board.mines, mineConf, rng);
+  }));
+  ConfigSampler sampler(full, board.mines);
+  timings["ConfigSampler::sample"].push_back(timeUs([&] { sampler.sample(mineConf, rng); }));
+
+  if (full.canEndgame) {
+    EndgameSolver endgame(board.rd);
+    timings["solveEndgame"].push_back(timeUs([&] { endgame.solveEndgame(board.mines); }));
+  }
+}
+
+static double percentile(const vector<double>& sorted, double p) {
+  int idx = (int) (p * (sorted.size() - 1) + 0.5);
+  return sorted[idx];
+}
+
+static void printTimings(unsigned seed, int boardsPerStage, const BenchmarkTimings& all) {
+  printf("{\n  \"seed\": %u,\n  \"boardsPerStage\": %d,\n  \"unit\": \"us\",\n  \"results\": {", seed, boardsPerStage);
+  bool firstKey = true;
+  for (const auto& [key, phases] : all) {
+    printf("%s\n    \"%s\": {", firstKey ? "" : ",", key.c_str());
+    firstKey = false;
+    bool firstPhase = true;
+    for (const auto& [phase, samples] : phases) {
+      vector<double> sorted = samples;
+      std::sort(sorted.begin(), sorted.end());
+      double sum = 0;
+      for (double t : sorted)
+        sum += t;
+      printf("%s\n      \"%s\": { \"count\": %d, \"mean\": %.2f, \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f }",
+             firstPhase ? "" : ",", phase.c_str(), (int) sorted.size(), sum / sorted.size(),
+             percentile(sorted, 0.5), percentile(sorted, 0.9), percentile(sorted, 0.99), sorted.back());
+      firstPhase = false;
+    }
+    printf("\n    }");
+  }
+  printf("\n  }\n}\n");
+}
+
+int runBenchmark(int argc, char** argv) {
+  unsigned seed = argc > 1 ? (unsigned) strtoul(argv[1], nullptr, 10) : 1;
+  int boardsPerStage = argc > 2 ? atoi(argv[2]) : 50;
+
+  vector<BenchmarkBoard> corpus = generateBenchmarkCorpus(seed, boardsPerStage);
+  std::mt19937 rng(seed);
+  BenchmarkTimings timings;
+  for (const BenchmarkBoard& board : corpus)
+    benchmarkBoard(board, timings[board.preset + "/" + board.stage], rng);
+
+  printTimings(seed, boardsPerStage, timings);
+#ifdef SOLVER_TRACE
+  traceWriteFile("trace.json");
+#endif
+  return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <random>
+using std::vector;
+using std::string;
+
+// A board of the benchmark corpus: the numbers shown to the player and the
+// number of mines on the board.
+struct BenchmarkBoard {
+  string preset;
+  string stage;
+  vector<vector<int>> rd;
+  int mines;
+};
+
+// Generates a reproducible corpus: for every preset (beginner, intermediate, expert)
+// and every stage (fraction of the safe cells revealed), boardsPerStage boards.
+vector<BenchmarkBoard> generateBenchmarkCorpus(unsigned seed, int boardsPerStage);
+
+// Times the solver phases separately on every board of the corpus and writes their
+// percentiles per preset and stage as JSON to stdout; with SOLVER_TRACE defined the
+// spans of the whole run also go to trace.json. Usage:
+//   MinesweeperSolver [seed] [boardsPerStage]
+// when built with BUILD_BENCHMARK defined.
+int runBenchmark(int argc, char** argv);
@@ -4,22 +4,51 @@ Board::Board(vector<vector<int>> raw_data) {
   height = (int) raw_data.size();
   width = (int) raw_data[0].size();
 
-  data = vector<vector<Cell>>(height);
-
+  data.reserve(height * width);
   for (int i = 0; i < height; ++i) {
     for (int j = 0; j < width; ++j) {
-      data[i].push_back(Cell(i, j, raw_data[i][j]));
+      data.push_back(Cell(i, j, raw_data[i][j]));
+      data.back().id = i * width + j;
       unsolved += (int) (raw_data[i][j] == -1);
     }
   }
+
+  neighborStart.reserve(height * width + 1);
+  neighborIds.reserve(height * width * 8);
+  for (int i = 0; i < height; ++i) {
+    for (int j = 0; j < width; ++j) {
+      neighborStart.push_back((int) neighborIds.size());
+      for (int ni = i - 1; ni < i + 2; ++ni) {
+        for (int nj = j - 1; nj < j + 2; ++nj) {
+          if ((ni != i || nj != j) && isValidCoord(ni, nj))
+            neighborIds.push_back(ni * width + nj);
+        }
+      }
+    }
+  }
+  neighborStart.push_back((int) neighborIds.size());
 }
 
 const Cell* Board::getCell(int r, int c) const {
-  return &data[r][c];
+  return &data[r * width + c];
 }
 
 Cell* Board::getCellMutable(int r, int c) {
-  return &data[r][c];
+  return &data[r * width + c];
+}
+
+Cell* Board::getCellById(int id) {
+  return &data[id];
+}
+
+int Board::cellCount() const {
+  return width * height;
+}
+
+// Returns the ids of the cells around cell `id`, in row-major order.
+Board::NeighborRange Board::neighbors(int id) const {
+  const int* base = neighborIds.data();
+  return { base + neighborStart[id], base + neighborStart[id + 1] };
 }
 
 bool Board::isValidCoord(int r, int c) const {
@@ -29,24 +58,22 @@ bool Board::isValidCoord(int r, int c) const {
 vector<Cell*> Board::noNeighborsCells() {
   vector<Cell*> out;
 
-  for (int i = 0; i < height; ++i) {
-    for (int j = 0; j < width; ++j) {
-      if (data[i][j].value != CELL_UNDISCOVERED)
-        continue;
-
-      bool hasNeighbor = false;
-      for (int ni = i-1; ni < i+2 && !hasNeighbor; ++ni) if (isValidCoord(ni, 0)) {
-        for (int nj = j - 1; nj < j + 2 && !hasNeighbor; ++nj) if (isValidCoord(ni, nj)) {
-          if (data[ni][nj].value >= 0)
-            hasNeighbor = true;
-        }
-      }
+  int n = cellCount();
+  for (int id = 0; id < n; ++id) {
+    if (data[id].value != CELL_UNDISCOVERED)
+      continue;
 
-      if (!hasNeighbor)
-        out.push_back(getCellMutable(i, j));
+    bool hasNeighbor = false;
+    for (int nid : neighbors(id)) {
+      if (data[nid].value >= 0) {
+        hasNeighbor = true;
+        break;
+      }
     }
+
+    if (!hasNeighbor)
+      out.push_back(&data[id]);
   }
 
   return out;
 }
-
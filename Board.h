@@ -6,7 +6,16 @@ using std::vector;
 
 class Board {
 public:
-  vector<vector<Cell>> data;
+  struct NeighborRange {
+    const int* first;
+    const int* last;
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+  };
+
+  vector<Cell> data;          // row-major, data[id] with id = r * width + c
+  vector<int> neighborStart;  // CSR offsets into neighborIds, cellCount() + 1 entries
+  vector<int> neighborIds;    // ids of the (up to 8) neighbors of every cell
   int width;
   int height;
   int unsolved = 0;
@@ -15,7 +24,9 @@ public:
   
   const Cell* getCell(int r, int c) const;
   Cell* getCellMutable(int r, int c);
+  Cell* getCellById(int id);
+  int cellCount() const;
+  NeighborRange neighbors(int id) const;
   bool isValidCoord(int r, int c) const;
   vector<Cell*> noNeighborsCells();
 };
-
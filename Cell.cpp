@@ -3,23 +3,18 @@
 Cell::Cell(int rv, int cv, int val) {
   r = rv;
   c = cv;
+  id = -1;
   value = val;
   minePerc = (val == CELL_FLAG) ? 100.f : (val >= CELL_NUMBER(0) ? 0.f : -1.f);
-  for (int i = 0; i < 9; ++i)
-    valuePerc[i] = minePerc >= 0 ? 0.f : -1.f;
-
-  if (value >= CELL_NUMBER(0))
-    valuePerc[value] = 100.f;
-
+  minePercErr = 0.f;
   disabled = false;
 }
 
 Cell::Cell(const Cell& origin) : Cell(origin.r, origin.c) {
+  this->id = origin.id;
   this->value = origin.value;
   this->minePerc = origin.minePerc;
-  for (int i = 0; i < 9; ++i)
-    this->valuePerc[i] = origin.valuePerc[i];
-  
+  this->minePercErr = origin.minePercErr;
   this->disabled = origin.isUnpredicted();
 }
 
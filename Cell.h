@@ -12,9 +12,10 @@ using std::vector;
 class Cell {
 public:
   int r, c;
+  int id; // dense index r * width + c, assigned by Board
   int value; // -4: floating, -3: dont care, -2: flag, -1: undiscovered, 0-9: value
   float minePerc;
-  float valuePerc[9];
+  float minePercErr; // standard error of minePerc when it was estimated by sampling, else 0
 
   vector<Group*> groups;
   bool disabled;
@@ -0,0 +1,184 @@
+#include "CellSet.h"
+#include "Board.h"
+#include <algorithm>
+#include <functional>
+
+CellSet::iterator::iterator(const CellSet* s, int wi) : s(s), wi(wi), bits(0) {
+  if (wi < s->hi) {
+    bits = s->words[wi];
+    skipEmpty();
+  }
+}
+
+void CellSet::iterator::skipEmpty() {
+  while (bits == 0 && ++wi < s->hi)
+    bits = s->words[wi];
+  if (bits == 0)
+    wi = s->hi;
+}
+
+Cell* CellSet::iterator::operator*() const {
+  return s->board->getCellById(wi * 64 + lowestBit64(bits));
+}
+
+CellSet::iterator& CellSet::iterator::operator++() {
+  bits &= bits - 1;
+  skipEmpty();
+  return *this;
+}
+
+CellSet::CellSet() {
+  board = nullptr;
+  lo = hi = 0;
+  count = 0;
+}
+
+CellSet::CellSet(Board* board) : CellSet() {
+  this->board = board;
+  words.assign((board->cellCount() + 63) / 64, 0);
+}
+
+void CellSet::insert(const Cell* cell) {
+  insert(cell->id);
+}
+
+void CellSet::insert(int id) {
+  int w = id >> 6;
+  uint64_t bit = 1ULL << (id & 63);
+  if (words[w] & bit)
+    return;
+
+  words[w] |= bit;
+  if (count == 0) {
+    lo = w;
+    hi = w + 1;
+  } else {
+    lo = std::min(lo, w);
+    hi = std::max(hi, w + 1);
+  }
+  count += 1;
+}
+
+void CellSet::erase(const Cell* cell) {
+  erase(cell->id);
+}
+
+void CellSet::erase(int id) {
+  if (!contains(id))
+    return;
+  words[id >> 6] &= ~(1ULL << (id & 63));
+  // Shrinks [lo, hi) too, which operator== and hash() rely on
+  recount();
+}
+
+bool CellSet::contains(const Cell* cell) const {
+  return contains(cell->id);
+}
+
+bool CellSet::contains(int id) const {
+  int w = id >> 6;
+  if (w < lo || w >= hi)
+    return false;
+  return (words[w] >> (id & 63)) & 1;
+}
+
+// Recomputes the cached size and shrinks [lo, hi) to the non-zero words.
+void CellSet::recount() {
+  while (lo < hi && words[lo] == 0)
+    lo += 1;
+  while (hi > lo && words[hi - 1] == 0)
+    hi -= 1;
+  if (lo >= hi)
+    lo = hi = 0;
+
+  count = 0;
+  for (int i = lo; i < hi; ++i)
+    count += popcount64(words[i]);
+}
+
+CellSet CellSet::intersect(const CellSet& other) const {
+  CellSet out;
+  out.board = board;
+  out.words.assign(words.size(), 0);
+  out.lo = std::max(lo, other.lo);
+  out.hi = std::min(hi, other.hi);
+  if (out.lo >= out.hi) {
+    out.lo = out.hi = 0;
+    return out;
+  }
+
+  for (int i = out.lo; i < out.hi; ++i)
+    out.words[i] = words[i] & other.words[i];
+  out.recount();
+  return out;
+}
+
+CellSet CellSet::subtract(const CellSet& other) const {
+  CellSet out;
+  out.board = board;
+  out.words.assign(words.size(), 0);
+  out.lo = lo;
+  out.hi = hi;
+
+  for (int i = lo; i < hi; ++i)
+    out.words[i] = (i >= other.lo && i < other.hi) ? (words[i] & ~other.words[i]) : words[i];
+  out.recount();
+  return out;
+}
+
+CellSet& CellSet::unite(const CellSet& other) {
+  if (board == nullptr) {
+    *this = other;
+    return *this;
+  }
+  if (other.count == 0)
+    return *this;
+
+  for (int i = other.lo; i < other.hi; ++i)
+    words[i] |= other.words[i];
+  if (count == 0) {
+    lo = other.lo;
+    hi = other.hi;
+  } else {
+    lo = std::min(lo, other.lo);
+    hi = std::max(hi, other.hi);
+  }
+  recount();
+  return *this;
+}
+
+int CellSet::intersectCount(const CellSet& other) const {
+  int out = 0;
+  int l = std::max(lo, other.lo);
+  int h = std::min(hi, other.hi);
+  for (int i = l; i < h; ++i)
+    out += popcount64(words[i] & other.words[i]);
+  return out;
+}
+
+bool CellSet::intersects(const CellSet& other) const {
+  int l = std::max(lo, other.lo);
+  int h = std::min(hi, other.hi);
+  for (int i = l; i < h; ++i) {
+    if (words[i] & other.words[i])
+      return true;
+  }
+  return false;
+}
+
+bool CellSet::operator==(const CellSet& other) const {
+  if (count != other.count || lo != other.lo || hi != other.hi)
+    return false;
+  for (int i = lo; i < hi; ++i) {
+    if (words[i] != other.words[i])
+      return false;
+  }
+  return true;
+}
+
+size_t CellSet::hash() const {
+  size_t h = std::hash<int>{}(lo);
+  for (int i = lo; i < hi; ++i)
+    h ^= std::hash<uint64_t>{}(words[i]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
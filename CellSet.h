@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+using std::vector;
+
+class Cell;
+class Board;
+
+inline int popcount64(uint64_t w) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return (int) __popcnt64(w);
+#else
+  return __builtin_popcountll(w);
+#endif
+}
+
+inline int lowestBit64(uint64_t w) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long idx;
+  _BitScanForward64(&idx, w);
+  return (int) idx;
+#else
+  return __builtin_ctzll(w);
+#endif
+}
+
+// A set of cells stored as a bitset over the board's dense cell ids.
+// Every set built from the same board has the same number of words, so
+// set operations are plain word-wise loops. [lo, hi) tracks the range of
+// words that may be non-zero, which keeps the loops short since groups
+// only ever span a few neighbouring rows.
+class CellSet {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Cell*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Cell* const*;
+    using reference = Cell*;
+
+    iterator(const CellSet* s, int wi);
+    Cell* operator*() const;
+    iterator& operator++();
+    iterator operator++(int) { iterator t = *this; ++(*this); return t; }
+    bool operator==(const iterator& o) const { return wi == o.wi && bits == o.bits; }
+    bool operator!=(const iterator& o) const { return !(*this == o); }
+
+  private:
+    const CellSet* s;
+    int wi;
+    uint64_t bits;
+    void skipEmpty();
+  };
+
+  Board* board;
+  vector<uint64_t> words;
+  int lo, hi;
+  int count;
+
+  CellSet();
+  explicit CellSet(Board* board);
+
+  void insert(const Cell*);
+  void insert(int id);
+  void erase(const Cell*);
+  void erase(int id);
+  bool contains(const Cell*) const;
+  bool contains(int id) const;
+  size_t size() const { return (size_t) count; }
+  bool empty() const { return count == 0; }
+
+  CellSet intersect(const CellSet&) const;
+  CellSet subtract(const CellSet&) const;
+  CellSet& unite(const CellSet&);
+  int intersectCount(const CellSet&) const;
+  bool intersects(const CellSet&) const;
+  bool operator==(const CellSet&) const;
+  size_t hash() const;
+
+  iterator begin() const { return iterator(this, lo); }
+  iterator end() const { return iterator(this, hi); }
+
+private:
+  void recount();
+};
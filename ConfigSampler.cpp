@@ -0,0 +1,151 @@
+#include "ConfigSampler.h"
+#include "Trace.h"
+
+// Vose's construction: cells of average weight are filled from an underfull entry
+// and topped up by an overfull one, which becomes the entry's alias.
+void ConfigSampler::AliasTable::build(const vector<double>& weights) {
+  int n = (int) weights.size();
+  double sum = 0;
+  for (double v : weights)
+    sum += v;
+
+  prob.assign(n, 1.0);
+  alias.assign(n, 0);
+  vector<double> scaled(n);
+  vector<int> small, large;
+  for (int i = 0; i < n; ++i) {
+    alias[i] = i;
+    scaled[i] = weights[i] * n / sum;
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+
+  while (!small.empty() && !large.empty()) {
+    int s = small.back(), l = large.back();
+    small.pop_back();
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] -= 1.0 - scaled[s];
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // Whatever is left only differs from 1 by rounding
+}
+
+int ConfigSampler::AliasTable::draw(std::mt19937& rng) const {
+  int n = (int) prob.size();
+  double x = std::uniform_real_distribution<double>(0.0, (double) n)(rng);
+  int i = min((int) x, n - 1);
+  return x - i < prob[i] ? i : alias[i];
+}
+
+ConfigSampler::ConfigSampler(const Solver& solver, int mines) {
+  TRACE_SCOPE("ConfigSampler");
+  ok = false;
+  height = solver.board.height;
+  width = solver.board.width;
+  fixed.assign(height, vector<int>(width, -1));
+
+  // Deduced cells and flags. Like generalSolve(), mines does not count the flags of
+  // the input, only the mines the solver deduced.
+  freeMines = mines;
+  for (int r = 0; r < height; ++r) {
+    for (int c = 0; c < width; ++c) {
+      const Cell* cell = solver.board.getCell(r, c);
+      if (cell->value >= 0 || cell->minePerc == 0.f) {
+        fixed[r][c] = 0;
+      } else if (cell->minePerc == 100.f) {
+        fixed[r][c] = 1;
+        if (solver.solvedCells.contains(cell))
+          freeMines -= 1;
+      }
+    }
+  }
+  for (const Cell* cell : solver.noNeighbors)
+    noNeighbors.push_back(cell->id);
+
+  Solver::SolveContext ctx;
+  ctx.chain_sols = solver.solveChains(solver.getGroupChains(), true);
+  if (!solver.weighChains(freeMines, ctx) || ctx.totalWeight == 0)
+    return;
+  totalTable.build(ctx.noMinesProb);
+  firstTotal = ctx.minMines + ctx.low;
+
+  // dp[i][s]: weighted number of ways chains i.. hold s mines, every row scaled on
+  // its own since only ratios within a row are used
+  int C = (int) ctx.chain_sols.size();
+  int maxMines = 0;
+  for (const Solver::ChainSolution& cs : ctx.chain_sols)
+    maxMines += cs.no_mines.back();
+  vector<vector<double>> dp(C + 1, vector<double>(maxMines + 1, 0.0));
+  dp[C][0] = 1.0;
+  for (int i = C - 1; i >= 0; --i) {
+    const Solver::ChainSolution& cs = ctx.chain_sols[i];
+    for (int s = 0; s <= maxMines; ++s) {
+      for (int j = 0; j < (int) cs.no_mines.size() && cs.no_mines[j] <= s; ++j)
+        dp[i][s] += cs.freq_no_mines[j] * dp[i + 1][s - cs.no_mines[j]];
+    }
+    normalizeCounts(dp[i]);
+  }
+
+  chains.resize(C);
+  for (int i = 0; i < C; ++i) {
+    Solver::ChainSolution& cs = ctx.chain_sols[i];
+    SampledChain& chain = chains[i];
+    for (const Cell* cell : cs.relatedCells)
+      chain.cells.push_back(cell->id);
+    chain.no_mines = cs.no_mines;
+
+    chain.byMines.assign(cs.no_mines.size(), vector<int>());
+    for (int ci = 0; ci < cs.all_configs.size(); ++ci) {
+      int m = cs.all_configs.mineCount(ci);
+      int j = (int) (std::lower_bound(cs.no_mines.begin(), cs.no_mines.end(), m) - cs.no_mines.begin());
+      chain.byMines[j].push_back(ci);
+    }
+    chain.configs = std::move(cs.all_configs);
+
+    chain.next.resize(maxMines + 1);
+    vector<double> weights(cs.no_mines.size());
+    for (int s = 0; s <= maxMines; ++s) {
+      if (dp[i][s] == 0)
+        continue;
+      for (int j = 0; j < (int) cs.no_mines.size(); ++j) {
+        int rest = s - cs.no_mines[j];
+        weights[j] = rest >= 0 ? cs.freq_no_mines[j] * dp[i + 1][rest] : 0;
+      }
+      chain.next[s].build(weights);
+    }
+  }
+  ok = true;
+}
+
+void ConfigSampler::sample(vector<vector<int>>& mineConf, std::mt19937& rng) const {
+  if (!ok) {
+    mineConf.assign(height, vector<int>(width, -1));
+    return;
+  }
+  mineConf = fixed;
+
+  int chainMines = firstTotal + totalTable.draw(rng);
+  int remaining = chainMines;
+  for (const SampledChain& chain : chains) {
+    int j = chain.next[remaining].draw(rng);
+    remaining -= chain.no_mines[j];
+
+    const vector<int>& bucket = chain.byMines[j];
+    int picked = bucket[std::uniform_int_distribution<int>(0, (int) bucket.size() - 1)(rng)];
+    for (int k = 0; k < (int) chain.cells.size(); ++k)
+      mineConf[chain.cells[k] / width][chain.cells[k] % width] = chain.configs.isMine(picked, k);
+  }
+
+  // The other mines go to cells next to no number, a partial shuffle picking them
+  int n = (int) noNeighbors.size();
+  int k = min(freeMines - chainMines, n);
+  vector<int> order = noNeighbors;
+  for (int i = 0; i < n; ++i) {
+    if (i < k)
+      std::swap(order[i], order[std::uniform_int_distribution<int>(i, n - 1)(rng)]);
+    mineConf[order[i] / width][order[i] % width] = i < k;
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Solver.h"
+#include "ConfigSet.h"
+#include <vector>
+#include <random>
+using std::vector;
+
+// Draws mine layouts of a solved board, uniformly among all layouts with the given
+// number of mines. Everything a draw needs is prepared once: the chain solutions
+// with their configurations bucketed by mine count, and an alias table for the
+// total chain mine count and for every chain's mine count given the mines left to
+// the chains after it. A draw is then a few table lookups per chain, and sample()
+// may be called concurrently with one rng per thread. The sampler copies what it
+// needs and does not refer to the solver afterwards.
+class ConfigSampler {
+public:
+  ConfigSampler(const Solver& solver, int mines);
+
+  bool valid() const { return ok; }
+  // Writes a layout to mineConf (1: mine, 0: safe), or -1 everywhere if the board
+  // has no layout with the given number of mines.
+  void sample(vector<vector<int>>& mineConf, std::mt19937& rng) const;
+
+private:
+  // Walker's alias method: draws index i with probability weights[i] / sum in O(1).
+  struct AliasTable {
+    vector<double> prob;
+    vector<int> alias;
+
+    void build(const vector<double>& weights);
+    int draw(std::mt19937& rng) const;
+  };
+
+  struct SampledChain {
+    vector<int> cells; // board cell ids, in relatedCells order
+    ConfigSet configs;
+    vector<int> no_mines;
+    vector<vector<int>> byMines; // configs with no_mines[j] mines
+    vector<AliasTable> next;     // [mines left to this chain and the later ones] -> j
+  };
+
+  bool ok;
+  int height, width;
+  vector<vector<int>> fixed; // deduced cells and numbers, -1 elsewhere
+  vector<SampledChain> chains;
+  AliasTable totalTable;     // chain mines - firstTotal
+  int firstTotal;
+  int freeMines;             // mines not in chains nor deduced
+  vector<int> noNeighbors;   // board cell ids
+};
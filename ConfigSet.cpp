@@ -0,0 +1,27 @@
+#include "ConfigSet.h"
+
+ConfigSet::ConfigSet() : ConfigSet(0) {}
+
+ConfigSet::ConfigSet(int nCells) {
+  this->nCells = nCells;
+  stride = (nCells + 63) / 64;
+  count = 0;
+}
+
+void ConfigSet::add(const uint64_t* mines) {
+  bits.insert(bits.end(), mines, mines + stride);
+  count += 1;
+}
+
+void ConfigSet::clear() {
+  bits.clear();
+  count = 0;
+}
+
+int ConfigSet::mineCount(int config) const {
+  const uint64_t* w = words(config);
+  int out = 0;
+  for (int i = 0; i < stride; ++i)
+    out += popcount64(w[i]);
+  return out;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CellSet.h"
+#include <vector>
+#include <cstdint>
+using std::vector;
+
+// The valid mine assignments of a chain, one bitset per configuration over the
+// chain's cells (bit i set = cell i of relatedCells is a mine), stored back to back
+// in a single buffer. This is 64x smaller than a vector<int> per configuration and
+// costs one allocation per growth step rather than one per configuration.
+class ConfigSet {
+public:
+  ConfigSet();
+  explicit ConfigSet(int nCells);
+
+  void add(const uint64_t* mines);
+  void clear();
+  int size() const { return count; }
+  bool empty() const { return count == 0; }
+  int cellCount() const { return nCells; }
+  size_t byteSize() const { return bits.capacity() * sizeof(uint64_t); }
+
+  bool isMine(int config, int cell) const {
+    return (bits[(size_t) config * stride + (cell >> 6)] >> (cell & 63)) & 1;
+  }
+  const uint64_t* words(int config) const { return bits.data() + (size_t) config * stride; }
+  int mineCount(int config) const;
+
+private:
+  int nCells;
+  int stride; // words per configuration
+  int count;
+  vector<uint64_t> bits;
+};
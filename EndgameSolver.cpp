@@ -7,8 +7,12 @@ using std::queue;
 
 #define byte int8_t
 
+// Stops once more than limit configurations were produced, so that a board with far
+// too many configurations for the endgame search is rejected without listing them all.
 void combineAllGroupsConfigs(const vector<Solver::ChainSolution>& chain_sols, vector<vector<byte>>& all_configs,
-                             vector<byte>& config, int mines, int id = 0, int arr_idx = 0) {
+                             vector<byte>& config, int mines, size_t limit, int id = 0, int arr_idx = 0) {
+  if (all_configs.size() > limit)
+    return;
   if (id == chain_sols.size()) {
     int remaining = config.size() - arr_idx;
     if (mines > remaining)
@@ -22,33 +26,34 @@ void combineAllGroupsConfigs(const vector<Solver::ChainSolution>& chain_sols, ve
       for (int i = 0; i < remaining; ++i)
         config[i + arr_idx] = bitmask[i];
       all_configs.push_back(config);
-    } while (next_permutation(bitmask.begin(), bitmask.end()));
+    } while (all_configs.size() <= limit && next_permutation(bitmask.begin(), bitmask.end()));
 
     return;
   }
 
-  for (const vector<int>& conf : chain_sols[id].all_configs) {
-    int nMines = 0;
-    for (int i = 0; i < conf.size(); ++i) {
-      bool n = conf[i];
-      nMines += n;
-      config[i + arr_idx] = -n;
-    }
-
+  const ConfigSet& confs = chain_sols[id].all_configs;
+  int nCells = confs.cellCount();
+  for (int ci = 0; ci < confs.size(); ++ci) {
+    int nMines = confs.mineCount(ci);
     if (nMines > mines)
       continue;
-    combineAllGroupsConfigs(chain_sols, all_configs, config, mines - nMines, id + 1, arr_idx + conf.size());
+    for (int i = 0; i < nCells; ++i)
+      config[i + arr_idx] = -(byte) confs.isMine(ci, i);
+
+    combineAllGroupsConfigs(chain_sols, all_configs, config, mines - nMines, limit, id + 1, arr_idx + nCells);
   }
 }
 
 EndgameSolver::EndgameSolver(vector<vector<int>> rd) : solver(rd) {
   numCells = 0;
   numConfigs = 0;
+  budget = nullptr;
 }
 
 bool EndgameSolver::buildConfigurations(int mines, int maxConfigs) {
-  bool valid = solver.generalSolve(mines);
-  if (!valid) return false;
+  TRACE_SCOPE("buildConfigurations");
+  bool valid = solver.generalSolve(mines, budget);
+  if (!valid || (budget && budget->exhausted())) return false;
 
   int remainingMines = mines;
   for (Cell* c : solver.solvedCells)
@@ -56,10 +61,14 @@ bool EndgameSolver::buildConfigurations(int mines, int maxConfigs) {
 
   if (remainingMines < 0) return false;
 
+  // generalSolve() counted the configurations unless there are too many cells or a
+  // chain was sampled; either way the search below would reject the board, after
+  // enumerating every chain
+  if (solver.numConfigurations == 0 || solver.numConfigurations > (uint64_t)maxConfigs) return false;
+
   vector<vector<Group*>> chains = solver.getGroupChains();
-  vector<Solver::ChainSolution> chain_sols;
-  for (const vector<Group*>& g : chains)
-    chain_sols.push_back(solver.solveChain(g));
+  vector<Solver::ChainSolution> chain_sols = solver.solveChains(chains, true, budget);
+  if (chain_sols.size() != chains.size()) return false;
 
   vector<Cell*> allCells;
   for (const Solver::ChainSolution& cs : chain_sols)
@@ -81,12 +90,11 @@ bool EndgameSolver::buildConfigurations(int mines, int maxConfigs) {
     if (c->minePerc != 0.f || c->value != CELL_SAFE) continue;
     if (tmpPosToIdx[c->r][c->c] >= 0) continue;
     bool adjacent = false;
-    for (int dr = -1; dr <= 1 && !adjacent; ++dr) {
-      for (int dc = -1; dc <= 1 && !adjacent; ++dc) {
-        if (dr == 0 && dc == 0) continue;
-        int nr = c->r + dr, nc = c->c + dc;
-        if (solver.board.isValidCoord(nr, nc) && tmpPosToIdx[nr][nc] >= 0)
-          adjacent = true;
+    for (int nid : solver.board.neighbors(c->id)) {
+      const Cell* n = solver.board.getCellById(nid);
+      if (tmpPosToIdx[n->r][n->c] >= 0) {
+        adjacent = true;
+        break;
       }
     }
     if (adjacent) allCells.push_back(c);
@@ -96,7 +104,7 @@ bool EndgameSolver::buildConfigurations(int mines, int maxConfigs) {
 
   vector<int8_t> config(uncertainCellCount, 0);
   vector<vector<int8_t>> all_configs;
-  combineAllGroupsConfigs(chain_sols, all_configs, config, remainingMines, 0, 0);
+  combineAllGroupsConfigs(chain_sols, all_configs, config, remainingMines, maxConfigs, 0, 0);
 
   if (all_configs.empty() || (int)all_configs.size() > maxConfigs) return false;
 
@@ -122,6 +130,7 @@ bool EndgameSolver::buildConfigurations(int mines, int maxConfigs) {
 }
 
 void EndgameSolver::precomputeRevealValues() {
+  TRACE_SCOPE("precomputeRevealValues");
   configRevealValue.assign(numConfigs, vector<int>(numCells, 0));
 
   for (int c = 0; c < numConfigs; ++c) {
@@ -132,21 +141,15 @@ void EndgameSolver::precomputeRevealValues() {
       }
 
       int count = 0;
-      int r = cellPos[i].first;
-      int col = cellPos[i].second;
-      for (int nr = r - 1; nr <= r + 1; ++nr) {
-        for (int nc = col - 1; nc <= col + 1; ++nc) {
-          if (nr == r && nc == col) continue;
-          if (!solver.board.isValidCoord(nr, nc)) continue;
-
-          int boardVal = solver.board.getCell(nr, nc)->value;
-          if (boardVal == CELL_FLAG) {
+      int id = cellPos[i].first * solver.board.width + cellPos[i].second;
+      for (int nid : solver.board.neighbors(id)) {
+        const Cell* n = solver.board.getCellById(nid);
+        if (n->value == CELL_FLAG) {
+          count++;
+        } else if (n->value == CELL_UNDISCOVERED) {
+          int idx = posToIdx[n->r][n->c];
+          if (idx >= 0 && configMine[c][idx])
             count++;
-          } else if (boardVal == CELL_UNDISCOVERED) {
-            int idx = posToIdx[nr][nc];
-            if (idx >= 0 && configMine[c][idx])
-              count++;
-          }
         }
       }
       configRevealValue[c][i] = count;
@@ -157,16 +160,12 @@ void EndgameSolver::precomputeRevealValues() {
 void EndgameSolver::buildAdjacency() {
   adjacency.resize(numCells);
   for (int i = 0; i < numCells; ++i) {
-    int r = cellPos[i].first;
-    int c = cellPos[i].second;
-    for (int nr = r - 1; nr <= r + 1; ++nr) {
-      for (int nc = c - 1; nc <= c + 1; ++nc) {
-        if (nr == r && nc == c) continue;
-        if (!solver.board.isValidCoord(nr, nc)) continue;
-        int idx = posToIdx[nr][nc];
-        if (idx >= 0)
-          adjacency[i].push_back(idx);
-      }
+    int id = cellPos[i].first * solver.board.width + cellPos[i].second;
+    for (int nid : solver.board.neighbors(id)) {
+      const Cell* n = solver.board.getCellById(nid);
+      int idx = posToIdx[n->r][n->c];
+      if (idx >= 0)
+        adjacency[i].push_back(idx);
     }
   }
 }
@@ -194,6 +193,7 @@ uint64_t EndgameSolver::simulateReveal(int cellIdx, int configIdx, uint64_t curr
 }
 
 double EndgameSolver::solve(uint64_t revealedMask, ConfigMask configMask) {
+  TRACE_SCOPE("EndgameSolver::solve");
   int totalAlive = configMask.popcount();
   if (totalAlive == 0) return 0.0;
   if (totalAlive == 1) return 1.0;
@@ -211,7 +211,12 @@ double EndgameSolver::solve(uint64_t revealedMask, ConfigMask configMask) {
 
   StateKey key = {revealedMask, configMask.words};
   auto it = memo.find(key);
-  if (it != memo.end()) return it->second;
+  if (it != memo.end()) {
+    stats.memoHits += 1;
+    return it->second;
+  }
+  stats.memoMisses += 1;
+  if (budget && budget->charge(1)) return 0.0;
 
   // First, click any cell that is safe in ALL alive configs (free information)
   for (int i = 0; i < numCells; ++i) {
@@ -237,11 +242,14 @@ double EndgameSolver::solve(uint64_t revealedMask, ConfigMask configMask) {
         obsGroups[obsKey].setBit(c);
       }
       double prob = 0.0;
+      stats.partitions += obsGroups.size();
       for (auto& [obsKey, groupMask] : obsGroups) {
         int groupSize = groupMask.popcount();
         prob += (double)groupSize / totalAlive * solve(obsKey.newRevealedMask, groupMask);
       }
-      memo[key] = prob;
+      // Once the budget ran out, results below this state are incomplete
+      if (!budget || !budget->exhausted())
+        memo[key] = prob;
       return prob;
     }
   }
@@ -281,6 +289,7 @@ double EndgameSolver::solve(uint64_t revealedMask, ConfigMask configMask) {
     }
 
     double prob = 0.0;
+    stats.partitions += obsGroups.size();
     for (auto& [obsKey, groupMask] : obsGroups) {
       int groupSize = groupMask.popcount();
       prob += (double)groupSize / totalAlive * solve(obsKey.newRevealedMask, groupMask);
@@ -289,17 +298,28 @@ double EndgameSolver::solve(uint64_t revealedMask, ConfigMask configMask) {
     bestProb = std::max(bestProb, prob);
   }
 
-  memo[key] = bestProb;
+  if (!budget || !budget->exhausted())
+    memo[key] = bestProb;
   return bestProb;
 }
 
-EndgameResult EndgameSolver::solveEndgame(int mines, int maxConfigs) {
-  EndgameResult result = {0.0, -1, -1, false};
+EndgameResult EndgameSolver::solveEndgame(int mines, int maxConfigs, SolveBudget* budget) {
+  TRACE_SCOPE("solveEndgame");
+  EndgameResult result = {0.0, -1, -1, false, SOLVE_STATUS_COMPLETE};
+  stats.clear();
+  this->budget = budget;
 
-  if (!buildConfigurations(mines, maxConfigs))
+  if (!buildConfigurations(mines, maxConfigs)) {
+    if (budget)
+      result.status = budget->status();
+    this->budget = nullptr;
     return result;
+  }
+  stats.configurations = numConfigs;
+  stats.cells = numCells;
 
   if (numCells == 0) {
+    this->budget = nullptr;
     result.winProbability = 1.0;
     result.valid = true;
     for (Cell* c : solver.solvedCells) {
@@ -321,8 +341,15 @@ EndgameResult EndgameSolver::solveEndgame(int mines, int maxConfigs) {
   for (int c = 0; c < numConfigs; ++c)
     allConfigs.setBit(c);
 
-  // Populate memo for all reachable states
+  // Populate memo for all reachable states. The best first move is replayed from
+  // the memo without the budget.
   double winProb = solve(initialRevealed, allConfigs);
+  stats.memoSize = memo.size();
+  this->budget = nullptr;
+  if (budget && budget->exhausted()) {
+    result.status = budget->status();
+    return result;
+  }
 
   // Find best first move by replaying the root decision
   // First check for cells safe in all configs (click for free)
@@ -380,6 +407,7 @@ EndgameResult EndgameSolver::solveEndgame(int mines, int maxConfigs) {
       }
 
       double prob = 0.0;
+      stats.partitions += obsGroups.size();
       for (auto& [obsKey, groupMask] : obsGroups) {
         int groupSize = groupMask.popcount();
         prob += (double)groupSize / numConfigs * solve(obsKey.newRevealedMask, groupMask);
@@ -16,6 +16,7 @@ struct EndgameResult {
   int bestRow;
   int bestCol;
   bool valid;
+  int status; // SOLVE_STATUS_*, valid is false unless the search completed
 };
 
 class EndgameSolver {
@@ -92,6 +93,8 @@ public:
   vector<vector<int>> adjacency;                   // [cell] -> list of neighbor cell indices
 
   std::unordered_map<StateKey, double, StateKeyHash> memo;
+  EndgameStats stats; // of the last solveEndgame(); solver.stats covers building the configurations
+  SolveBudget* budget; // of the running solveEndgame(), if any
 
   EndgameSolver(vector<vector<int>> rd);
 
@@ -100,5 +103,5 @@ public:
   void buildAdjacency();
   uint64_t simulateReveal(int cellIdx, int configIdx, uint64_t currentRevealed) const;
   double solve(uint64_t revealedMask, ConfigMask configMask);
-  EndgameResult solveEndgame(int mines, int maxConfigs = MAX_ENDGAME_CONFIGS);
+  EndgameResult solveEndgame(int mines, int maxConfigs = MAX_ENDGAME_CONFIGS, SolveBudget* budget = nullptr);
 };
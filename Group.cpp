@@ -1,9 +1,12 @@
 #include "Group.h"
+#include "GroupPool.h"
 
 Group::Group() {
   minV = maxV = 0;
   id = -1;
+  serial = 0;
   disabled = false;
+  pendingCross = pendingSync = false;
 }
 
 Group::Group(int row, int col, Board& board) : Group() {
@@ -11,39 +14,20 @@ Group::Group(int row, int col, Board& board) : Group() {
   if (mines < 0)
     return;
 
-  for (int nr = row - 1; nr < row + 2; ++nr) {
-    for (int nc = col - 1; nc < col + 2; ++nc) {
-      if (!board.isValidCoord(nr, nc))
-        continue;
-      
-      int v = board.getCell(nr, nc)->value;
-      if (v >= 0)
-        continue;
-      if (v == CELL_UNDISCOVERED)
-        groupcells.insert(board.getCellMutable(nr, nc));
-      else if (v == CELL_FLAG)
-        mines -= 1;
-    }
+  groupcells = CellSet(&board);
+  for (int nid : board.neighbors(row * board.width + col)) {
+    int v = board.getCellById(nid)->value;
+    if (v == CELL_UNDISCOVERED)
+      groupcells.insert(nid);
+    else if (v == CELL_FLAG)
+      mines -= 1;
   }
 
   minV = maxV = mines;
   cellSync();
 }
 
-Group::Group(const Group* group, Board* board) : Group() {
-  minV = group->minV;
-  maxV = group->maxV;
-  id = group->id;
-
-  for (const Cell* cell : group->groupcells) {
-    groupcells.insert(board->getCellMutable(cell->r, cell->c));
-    board->getCellMutable(cell->r, cell->c)->disabled = false;
-  }
-
-  cellSync();
-}
-
-Group::Group(const set<Cell*>& groupcells, int maxMines) : Group() {
+Group::Group(const CellSet& groupcells, int maxMines) : Group() {
   this->groupcells = groupcells;
   minV = 0;
   maxV = (int) groupcells.size();
@@ -53,18 +37,12 @@ Group::Group(const set<Cell*>& groupcells, int maxMines) : Group() {
   cellSync();
 }
 
-set<Cell*> Group::intersect(const set<Cell*>& other) const {
-  vector<Cell*> out(min(groupcells.size(), other.size()));
-  vector<Cell*>::iterator it = set_intersection(groupcells.begin(), groupcells.end(), 
-                                                other.begin(), other.end(), out.begin());
-  return set<Cell*>(out.begin(), it);
+CellSet Group::intersect(const CellSet& other) const {
+  return groupcells.intersect(other);
 }
 
-set<Cell*> Group::subtract(const set<Cell*>& other) const {
-  vector<Cell*> out(groupcells.size());
-  vector<Cell*>::iterator it = set_difference(groupcells.begin(), groupcells.end(),
-                                              other.begin(), other.end(), out.begin());
-  return set<Cell*>(out.begin(), it);
+CellSet Group::subtract(const CellSet& other) const {
+  return groupcells.subtract(other);
 }
 
 void Group::cellSync() {
@@ -72,12 +50,25 @@ void Group::cellSync() {
     cell->groups.push_back(this);
 }
 
+// Removes this group from the group lists of its cells, searching from the back
+// since a group is usually dropped right after it was created.
+void Group::cellUnsync() {
+  for (Cell* cell : groupcells) {
+    for (int i = (int) cell->groups.size() - 1; i >= 0; --i) {
+      if (cell->groups[i] != this)
+        continue;
+      cell->groups.erase(cell->groups.begin() + i);
+      break;
+    }
+  }
+}
+
 bool Group::isDisjoint(const Group& other) const {
-  return intersect(other.groupcells).size() == 0;
+  return !groupcells.intersects(other.groupcells);
 }
 
 int Group::groupRelation(const Group& other) const {
-  int ilen = (int) intersect(other.groupcells).size();
+  int ilen = groupcells.intersectCount(other.groupcells);
   int len1 = (int) this->groupcells.size();
   int len2 = (int) other.groupcells.size();
   
@@ -140,31 +131,31 @@ bool Group::merge(Group& other) {
   return true;
 }
 
-vector<Group*> Group::subcross(const Group& other) {
-  set<Cell*> diff = other.subtract(groupcells);
-  Group* newGroup = new Group(diff);
+vector<Group*> Group::subcross(const Group& other, GroupPool& pool) {
+  CellSet diff = other.subtract(groupcells);
+  Group* newGroup = pool.create(diff);
   sync(*newGroup, other.minV, other.maxV);
   vector<Group*> out;
   out.push_back(newGroup);
   return out;
 }
 
-vector<Group*> Group::cross(Group& other) {
+vector<Group*> Group::cross(Group& other, GroupPool& pool) {
   int rel = groupRelation(other);
   if (rel == RELATION_DISJOINT)
     return vector<Group*>();
   if (rel == RELATION_SUBSET)
-    return this->subcross(other);
+    return this->subcross(other, pool);
   if (rel == RELATION_SUPERSET)
-    return other.subcross(*this);
+    return other.subcross(*this, pool);
 
-  set<Cell*> intercells = intersect(other.groupcells);
-  set<Cell*> left = subtract(intercells);
-  set<Cell*> right = other.subtract(intercells);
+  CellSet intercells = intersect(other.groupcells);
+  CellSet left = subtract(intercells);
+  CellSet right = other.subtract(intercells);
 
-  Group* g1 = new Group(left);
-  Group* g2 = new Group(intercells);
-  Group* g3 = new Group(right);
+  Group* g1 = pool.create(left);
+  Group* g2 = pool.create(intercells);
+  Group* g3 = pool.create(right);
 
   g1->sync(*g2, minV, maxV);
   g3->sync(*g2, other.minV, other.maxV);
@@ -176,21 +167,3 @@ vector<Group*> Group::cross(Group& other) {
   out.push_back(g3);
   return out;
 }
-
-vector<Group*> Group::getOverlaps() const {
-  vector<Group*> out;
-  set<int> ids;
-  ids.insert(this->id);
-  for (Cell* c : groupcells) {
-    for (Group* g : c->groups) {
-      if (ids.count(g->id) == 1)
-        continue;
-      out.push_back(g);
-      ids.insert(g->id);
-    }
-  }
-  return out;
-}
-
-
-
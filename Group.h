@@ -2,42 +2,45 @@
 
 #include "Cell.h"
 #include "Board.h"
+#include "CellSet.h"
 #include "Macros.h"
 #include <vector>
 #include <set>
 #include <algorithm>
 using std::vector;
 using std::set;
-using std::set_intersection;
-using std::set_difference;
 
 #include <cmath>
 using std::min;
 using std::max;
 
+class GroupPool;
+
 class Group {
 public:
-  set<Cell*> groupcells;
+  CellSet groupcells;
   int minV;
   int maxV;
   int id;
+  uint64_t serial; // never reused within a solver, unlike id
   bool disabled;
+  bool pendingCross; // queued in Solver::crossQueue
+  bool pendingSync;  // queued in Solver::syncQueue
 
   Group();
   Group(int, int, Board&);
-  Group(const Group*, Board*);
-  Group(const set<Cell*>&, int=-1);
+  Group(const CellSet&, int=-1);
 
-  set<Cell*> intersect(const set<Cell*>&) const;
-  set<Cell*> subtract(const set<Cell*>&) const;
+  CellSet intersect(const CellSet&) const;
+  CellSet subtract(const CellSet&) const;
 
   void cellSync();
+  void cellUnsync();
   bool isDisjoint(const Group&) const;
   int groupRelation(const Group&) const;
   int sync(Group&, int = -1, int = -1);
   bool merge(Group&);
-  vector<Group*> subcross(const Group&);
-  vector<Group*> cross(Group&);
-  vector<Group*> getOverlaps() const;
+  vector<Group*> subcross(const Group&, GroupPool&);
+  vector<Group*> cross(Group&, GroupPool&);
 };
 
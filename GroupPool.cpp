@@ -0,0 +1,39 @@
+#include "GroupPool.h"
+
+GroupPool::GroupPool() {
+  used = 0;
+}
+
+GroupPool::~GroupPool() {
+  reset();
+  for (Slot* chunk : chunks)
+    delete[] chunk;
+}
+
+Group* GroupPool::slotAt(int i) const {
+  return reinterpret_cast<Group*>(&chunks[i / CHUNK_SIZE][i % CHUNK_SIZE]);
+}
+
+Group* GroupPool::nextSlot() {
+  if (used == (int) chunks.size() * CHUNK_SIZE)
+    chunks.push_back(new Slot[CHUNK_SIZE]);
+  return slotAt(used++);
+}
+
+// Hands a group back to the pool. The caller must already have unlinked it from
+// its cells and from the solver.
+void GroupPool::release(Group* g) {
+  freeSlots.push_back(g);
+}
+
+// Destroys every group, keeping the allocated chunks for the next solve.
+void GroupPool::reset() {
+  for (int i = 0; i < used; ++i)
+    slotAt(i)->~Group();
+  used = 0;
+  freeSlots.clear();
+}
+
+int GroupPool::liveCount() const {
+  return used - (int) freeSlots.size();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Group.h"
+#include <vector>
+#include <new>
+#include <utility>
+using std::vector;
+
+// Chunked storage for the groups of one solve. Slots are handed out in order and
+// recycled through a free list; released groups are only destroyed when their slot
+// is reused, on reset() or when the pool goes away, so every group of a solver is
+// freed in bulk. reset() keeps the chunks for the next board.
+class GroupPool {
+public:
+  GroupPool();
+  ~GroupPool();
+  GroupPool(const GroupPool&) = delete;
+  GroupPool& operator=(const GroupPool&) = delete;
+
+  template <typename... Args>
+  Group* create(Args&&... args) {
+    Group* slot;
+    if (!freeSlots.empty()) {
+      slot = freeSlots.back();
+      freeSlots.pop_back();
+      slot->~Group();
+    } else {
+      slot = nextSlot();
+    }
+    return new (slot) Group(std::forward<Args>(args)...);
+  }
+
+  void release(Group* g);
+  void reset();
+  int liveCount() const;
+
+private:
+  static const int CHUNK_SIZE = 256;
+
+  struct alignas(Group) Slot {
+    unsigned char bytes[sizeof(Group)];
+  };
+
+  vector<Slot*> chunks;
+  vector<Group*> freeSlots;
+  int used; // slots handed out so far, all of them hold a constructed Group
+
+  Group* nextSlot();
+  Group* slotAt(int i) const;
+};
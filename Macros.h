@@ -19,3 +19,57 @@
 
 #define MAX_ENDGAME_CONFIGS 400
 #define MAX_ENDGAME_CELLS 64
+// generalSolve stops counting configurations here
+#define CONFIG_COUNT_BOUND 100000
+
+// Every group is a subset of the 8 neighbors of a number
+#define MAX_GROUP_CELLS 8
+
+// Entries of the shared log(k!) table, see logFactorial(); larger k use lgamma
+#define LOG_FACTORIAL_TABLE 4096
+
+// Solver::eliminate() skips connected sets of exact groups over more cells than this
+#define ELIMINATION_MAX_CELLS 256
+
+// Memory Solver::ChainCache may hold, and the most configurations kept with one
+// chain solution for the callers that need them (endgame, sampling)
+#define CHAIN_CACHE_BYTES (32 << 20)
+#define CHAIN_CACHE_MAX_CONFIGS 4096
+
+// How generalSolve counts the configurations of a chain
+#define CHAIN_ENGINE_ENUMERATE 0
+#define CHAIN_ENGINE_FRONTIER  1
+#define CHAIN_ENGINE_AUTO      2
+#define CHAIN_ENGINE_APPROX    3
+
+// CHAIN_ENGINE_AUTO sweeps chains with at least this many cells, as long as no
+// more than FRONTIER_MAX_WIDTH cells are open at any step of the sweep
+#define FRONTIER_MIN_CELLS 24
+#define FRONTIER_MAX_WIDTH 20
+
+// CHAIN_ENGINE_AUTO splits chains too wide to sweep by conditioning on every
+// assignment of a cut of at most this many cells, see Solver::solveChainSplit
+#define SPLIT_MAX_CUT 10
+
+// CHAIN_ENGINE_AUTO samples chains with at least this many cells (Solver::approxMinCells)
+// that are too wide to sweep, instead of enumerating them. Sampling a chain runs passes
+// of APPROX_PARTICLES particles for APPROX_TIME_MS milliseconds (Solver::approxTimeMs)
+// or APPROX_MAX_SAMPLES particles.
+#define APPROX_MIN_CELLS 64
+#define APPROX_PARTICLES 256
+#define APPROX_MAX_SAMPLES 200000
+#define APPROX_TIME_MS 20
+
+// Outcome of a budgeted solve, see SolveBudget
+#define SOLVE_STATUS_COMPLETE     0
+#define SOLVE_STATUS_TIMED_OUT    1
+#define SOLVE_STATUS_OUT_OF_NODES 2
+#define SOLVE_STATUS_CANCELLED    3
+
+// Search nodes a hot loop counts locally between two SolveBudget::charge() calls
+#define BUDGET_POLL_INTERVAL 1024
+
+// Worker threads used for chain enumeration, 0: one per hardware thread
+#ifndef SOLVER_THREADS
+#define SOLVER_THREADS 0
+#endif
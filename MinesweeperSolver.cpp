@@ -2,10 +2,17 @@
 #include <fstream>
 #include <vector>
 #include <chrono>
+#include <algorithm>
 #include "Solver.h"
 #include "EndgameSolver.h"
+#include "SolverSession.h"
+#include "ConfigSampler.h"
+#include "Benchmark.h"
+#include "SelfTest.h"
 
 #define BUILD_EMSDK
+// Define BUILD_BENCHMARK (e.g. -DBUILD_BENCHMARK) to make main() run the benchmark
+// of Benchmark.cpp instead, or BUILD_SELFTEST to run the checks of SelfTest.cpp
 
 using std::ifstream;
 using std::cout;
@@ -14,42 +21,148 @@ using std::vector;
 #ifdef BUILD_EMSDK
 extern "C" {
   bool solveBoard(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame);
+  bool solveBoardStats(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame, double* stats);
+  bool solveBoardBudget(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame,
+                        double timeLimitMs, double nodeLimit, int* status);
+  bool solveBoardErrors(int nrows, int ncols, int* nums, int mines, float* prob, float* err, bool* canEndgame);
+  int solveBoards(int nboards, int* shapes, int* offsets, int* nums, int* mines, float* prob,
+                  bool* valid, bool* canEndgame);
   bool solveEndgame(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol);
+  bool solveEndgameStats(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol,
+                         double* stats);
+  bool solveEndgameBudget(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol,
+                          double timeLimitMs, double nodeLimit, int* status);
+  SolverSession* createSession(int nrows, int ncols, int* nums);
+  bool updateSession(SolverSession* session, int nupdates, int* updates, int mines, float* prob, bool* canEndgame);
+  void destroySession(SolverSession* session);
+  void sessionStats(SolverSession* session, double* stats);
+  int sampleBoards(int nrows, int ncols, int* nums, int mines, int nsamples, unsigned seed, int* out);
 }
 #endif
 
-bool solveBoard(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame) {
+static vector<vector<int>> readBoard(int nrows, int ncols, const int* nums) {
   vector<vector<int>> rd(nrows, vector<int>(ncols));
   for (int i = 0; i < nrows; ++i) {
     for (int j = 0; j < ncols; ++j)
       rd[i][j] = nums[i * ncols + j];
   }
+  return rd;
+}
 
-  Solver solver(rd);
-  bool valid = solver.generalSolve(mines);
+static SolveOptions budgetOptions(double timeLimitMs, double nodeLimit) {
+  SolveOptions options;
+  options.timeLimitMs = timeLimitMs;
+  options.nodeLimit = nodeLimit > 0 ? (uint64_t) nodeLimit : 0;
+  return options;
+}
+
+static bool solveBoardWith(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame,
+                           double* stats, SolveBudget* budget, float* err = nullptr) {
+  Solver solver(readBoard(nrows, ncols, nums));
+  bool valid = solver.generalSolve(mines, budget);
 
   if (valid) {
     for (int i = 0; i < nrows; ++i) {
       for (int j = 0; j < ncols; ++j) {
         const Cell* cell = solver.board.getCell(i, j);
         prob[i*ncols + j] = cell->minePerc;
+        if (err)
+          err[i*ncols + j] = cell->minePercErr;
       }
     }
   }
 
   *canEndgame = solver.canEndgame;
+  if (stats)
+    solver.stats.writeTo(stats);
   return valid;
 }
 
-bool solveEndgame(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol) {
-  vector<vector<int>> rd(nrows, vector<int>(ncols));
+bool solveBoard(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame) {
+  return solveBoardWith(nrows, ncols, nums, mines, prob, canEndgame, nullptr, nullptr);
+}
+
+// Like solveBoard, and writes the SOLVER_STATS_COUNT counters of SolverStats to stats.
+bool solveBoardStats(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame, double* stats) {
+  return solveBoardWith(nrows, ncols, nums, mines, prob, canEndgame, stats, nullptr);
+}
+
+// Like solveBoard, but stops after timeLimitMs milliseconds or nodeLimit search nodes
+// (0: no limit). status receives a SOLVE_STATUS_* code; unless it is
+// SOLVE_STATUS_COMPLETE, only the deduced cells have a probability and the others
+// are -1.
+bool solveBoardBudget(int nrows, int ncols, int* nums, int mines, float* prob, bool* canEndgame,
+                      double timeLimitMs, double nodeLimit, int* status) {
+  SolveBudget budget(budgetOptions(timeLimitMs, nodeLimit));
+  bool valid = solveBoardWith(nrows, ncols, nums, mines, prob, canEndgame, nullptr, &budget);
+  *status = budget.status();
+  return valid;
+}
+
+// Like solveBoard, and writes to err the standard error of every probability, in
+// percent. It is 0 everywhere unless a chain was too large to count exactly and its
+// probabilities were estimated by sampling.
+bool solveBoardErrors(int nrows, int ncols, int* nums, int mines, float* prob, float* err, bool* canEndgame) {
+  return solveBoardWith(nrows, ncols, nums, mines, prob, canEndgame, nullptr, nullptr, err);
+}
+
+// Rough cost of solving a board: the number of undiscovered cells next to a number,
+// which is what the chain enumeration grows with.
+static int estimateBoardCost(int nrows, int ncols, const int* nums) {
+  int cost = 0;
   for (int i = 0; i < nrows; ++i) {
-    for (int j = 0; j < ncols; ++j)
-      rd[i][j] = nums[i * ncols + j];
+    for (int j = 0; j < ncols; ++j) {
+      if (nums[i * ncols + j] != CELL_UNDISCOVERED)
+        continue;
+      bool frontier = false;
+      for (int di = -1; di <= 1 && !frontier; ++di) {
+        for (int dj = -1; dj <= 1; ++dj) {
+          int r = i + di, c = j + dj;
+          if (r >= 0 && r < nrows && c >= 0 && c < ncols && nums[r * ncols + c] >= 0) {
+            frontier = true;
+            break;
+          }
+        }
+      }
+      cost += frontier;
+    }
   }
+  return cost;
+}
 
-  EndgameSolver endgame(rd);
-  EndgameResult result = endgame.solveEndgame(mines);
+// Solves nboards boards at once. Board b is shapes[2*b] x shapes[2*b + 1] and starts
+// at offsets[b] in both nums and prob; its results go to prob, valid[b] and
+// canEndgame[b] as for solveBoard(). Boards are spread over the shared thread pool,
+// most expensive first, so that a few hard boards do not end up last on one worker.
+// Returns the number of valid boards.
+int solveBoards(int nboards, int* shapes, int* offsets, int* nums, int* mines, float* prob,
+                bool* valid, bool* canEndgame) {
+  vector<int> cost(nboards);
+  vector<int> order(nboards);
+  for (int b = 0; b < nboards; ++b) {
+    cost[b] = estimateBoardCost(shapes[2*b], shapes[2*b + 1], nums + offsets[b]);
+    order[b] = b;
+  }
+  std::stable_sort(order.begin(), order.end(), [&cost](int a, int b) {
+    return cost[a] > cost[b];
+  });
+
+  ThreadPool::shared().parallelFor(nboards, [&](int k) {
+    int b = order[k];
+    valid[b] = solveBoard(shapes[2*b], shapes[2*b + 1], nums + offsets[b], mines[b],
+                          prob + offsets[b], canEndgame + b);
+  });
+
+  int nvalid = 0;
+  for (int b = 0; b < nboards; ++b)
+    nvalid += valid[b];
+  return nvalid;
+}
+
+static bool solveEndgameWith(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol,
+                             double* stats, SolveBudget* budget) {
+  EndgameSolver endgame(readBoard(nrows, ncols, nums));
+  EndgameResult result = endgame.solveEndgame(mines, MAX_ENDGAME_CONFIGS, budget);
 
   if (result.valid) {
     *winProb = (float)result.winProbability;
@@ -57,10 +170,107 @@ bool solveEndgame(int nrows, int ncols, int* nums, int mines, float* winProb, in
     *bestCol = result.bestCol;
   }
 
+  if (stats) {
+    endgame.stats.writeTo(stats);
+    endgame.solver.stats.writeTo(stats + ENDGAME_STATS_COUNT);
+  }
   return result.valid;
 }
 
-int main() {
+bool solveEndgame(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol) {
+  return solveEndgameWith(nrows, ncols, nums, mines, winProb, bestRow, bestCol, nullptr, nullptr);
+}
+
+// Like solveEndgame, and writes the ENDGAME_STATS_COUNT counters of EndgameStats
+// followed by the SOLVER_STATS_COUNT counters of its solver to stats.
+bool solveEndgameStats(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol,
+                       double* stats) {
+  return solveEndgameWith(nrows, ncols, nums, mines, winProb, bestRow, bestCol, stats, nullptr);
+}
+
+// Like solveEndgame, with the limits and status of solveBoardBudget. Returns false
+// when the search did not complete.
+bool solveEndgameBudget(int nrows, int ncols, int* nums, int mines, float* winProb, int* bestRow, int* bestCol,
+                        double timeLimitMs, double nodeLimit, int* status) {
+  SolveBudget budget(budgetOptions(timeLimitMs, nodeLimit));
+  bool valid = solveEndgameWith(nrows, ncols, nums, mines, winProb, bestRow, bestCol, nullptr, &budget);
+  *status = budget.status();
+  return valid;
+}
+
+SolverSession* createSession(int nrows, int ncols, int* nums) {
+  return new SolverSession(readBoard(nrows, ncols, nums));
+}
+
+// updates holds nupdates (row, col, value) triples of newly revealed numbers and flags.
+// Pass nupdates = 0 to solve the session board as it is.
+bool updateSession(SolverSession* session, int nupdates, int* updates, int mines, float* prob, bool* canEndgame) {
+  vector<CellUpdate> cellUpdates(nupdates);
+  for (int i = 0; i < nupdates; ++i)
+    cellUpdates[i] = { updates[3*i], updates[3*i + 1], updates[3*i + 2] };
+
+  bool valid = session->update(cellUpdates, mines);
+  Solver& solver = session->solver;
+
+  if (valid) {
+    int nrows = solver.board.height;
+    int ncols = solver.board.width;
+    for (int i = 0; i < nrows; ++i) {
+      for (int j = 0; j < ncols; ++j) {
+        const Cell* cell = solver.board.getCell(i, j);
+        prob[i*ncols + j] = cell->minePerc;
+      }
+    }
+  }
+
+  *canEndgame = solver.canEndgame;
+  return valid;
+}
+
+void destroySession(SolverSession* session) {
+  delete session;
+}
+
+// Writes the SOLVER_STATS_COUNT counters of the session's solver, accumulated since
+// it was created or last rebuilt.
+void sessionStats(SolverSession* session, double* stats) {
+  session->solver.stats.writeTo(stats);
+}
+
+// Solves the board and draws nsamples mine layouts of it, uniformly among the layouts
+// with mines mines, seeded with seed. Layout s goes to out[s * nrows * ncols], 1 for
+// a mine and 0 elsewhere. Returns the number of layouts written: nsamples, or 0 if
+// the board has no layout.
+int sampleBoards(int nrows, int ncols, int* nums, int mines, int nsamples, unsigned seed, int* out) {
+  Solver solver(readBoard(nrows, ncols, nums));
+  if (!solver.generalSolve(mines))
+    return 0;
+  ConfigSampler sampler(solver, mines);
+  if (!sampler.valid())
+    return 0;
+
+  std::mt19937 rng(seed);
+  vector<vector<int>> mineConf;
+  for (int s = 0; s < nsamples; ++s) {
+    sampler.sample(mineConf, rng);
+    for (int i = 0; i < nrows; ++i) {
+      for (int j = 0; j < ncols; ++j)
+        out[(s * nrows + i) * ncols + j] = mineConf[i][j];
+    }
+  }
+  return nsamples;
+}
+
+int main(int argc, char** argv) {
+  (void) argc;
+  (void) argv;
+#ifdef BUILD_BENCHMARK
+  return runBenchmark(argc, argv);
+#endif
+#ifdef BUILD_SELFTEST
+  return runSelfTest() == 0 ? 0 : 1;
+#endif
+
 #ifndef BUILD_EMSDK
   ifstream inp("minesweeper.inp");
   int h, w, mines;
@@ -78,6 +288,8 @@ int main() {
   bool valid = solver.generalSolve(mines);
   auto t1 = std::chrono::high_resolution_clock::now();
   cout << "Done solving (" << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms)\n";
+  cout << "Number of configurations: " << solver.numConfigurations
+       << (solver.numConfigurations == CONFIG_COUNT_BOUND ? "+" : "") << "\n";
 
   if (valid)
     solver.printProb();
@@ -97,6 +309,10 @@ int main() {
     cout << "Endgame solver not applicable (too many configs or cells)\n";
   }
 
+#ifdef SOLVER_TRACE
+  traceWriteFile("trace.json");
+#endif
+
 #endif
 
   return 0;
@@ -0,0 +1,257 @@
+#include "SelfTest.h"
+#include "Solver.h"
+#include "SolverSession.h"
+#include "ConfigSampler.h"
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include <random>
+
+#define SELFTEST_CHECK(cond) \
+  do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures += 1; } } while (0)
+
+static int failures = 0;
+
+// A set that loses its only cell in the highest (or lowest) word must be
+// indistinguishable from the same set built directly.
+static void testCellSetErase() {
+  Board board(vector<vector<int>>(9, vector<int>(9, CELL_UNDISCOVERED)));
+  CellSet both(&board), low(&board), high(&board);
+  both.insert(5);
+  both.insert(70);
+  low.insert(5);
+  high.insert(70);
+
+  CellSet a = both;
+  a.erase(70);
+  SELFTEST_CHECK(a == low);
+  SELFTEST_CHECK(a.hash() == low.hash());
+
+  CellSet b = both;
+  b.erase(5);
+  SELFTEST_CHECK(b == high);
+  SELFTEST_CHECK(b.hash() == high.hash());
+}
+
+// Revealing (7, 7), cell 70, takes it out of groups that also hold cells of the
+// first word. The remaining groups must still merge with equal groups derived
+// afterwards, and the session must agree with a fresh solve.
+static void testSessionGroupLosesHighWord() {
+  vector<vector<int>> rd = {
+    { 0, 0, 0, 0, 0, 0, 0, 1,-1 },
+    { 0, 0, 0, 0, 0, 0, 0, 1, 1 },
+    { 0, 0, 0, 0, 1, 1, 1, 0, 0 },
+    { 0, 0, 0, 1, 2,-1, 2, 1, 1 },
+    { 0, 0, 0, 2,-1,-1,-1,-1,-1 },
+    { 0, 0, 0, 2,-1,-1,-1,-1,-1 },
+    { 0, 0, 0, 2,-1,-1,-1,-1, 1 },
+    { 0, 1, 1, 2,-1,-1,-1,-1, 1 },
+    { 0, 1,-1,-1,-1, 2, 2,-1,-1 },
+  };
+  int mines = 10;
+  SolverSession session(rd);
+  SELFTEST_CHECK(session.update({}, mines));
+  SELFTEST_CHECK(session.update({ { 7, 7, 2 } }, mines));
+  SELFTEST_CHECK(session.consistent);
+
+  std::map<vector<int>, int> seen;
+  for (Group* g : session.solver.groups) {
+    if (g->disabled)
+      continue;
+    vector<int> ids;
+    for (Cell* c : g->groupcells)
+      ids.push_back(c->id);
+    SELFTEST_CHECK(seen[ids]++ == 0);
+  }
+
+  rd[7][7] = 2;
+  Solver fresh(rd);
+  SELFTEST_CHECK(fresh.generalSolve(mines));
+  for (int i = 0; i < (int) rd.size(); ++i) {
+    for (int j = 0; j < (int) rd[i].size(); ++j) {
+      float p = session.solver.board.getCell(i, j)->minePerc;
+      SELFTEST_CHECK(std::fabs(p - fresh.board.getCell(i, j)->minePerc) < 1e-3f);
+    }
+  }
+}
+
+// The mines passed to the sampler exclude the flags of the input, as for
+// generalSolve(). (1, 4) is a deduced mine and the two other mines fall among
+// the six cells of the last two columns, which touch no number.
+static void testSamplerWithFlag() {
+  vector<vector<int>> rd = {
+    { CELL_FLAG, 1, 0, 1,-1,-1,-1 },
+    {         1, 1, 0, 1,-1,-1,-1 },
+    {         0, 0, 0, 1,-1,-1,-1 },
+  };
+  int mines = 3;
+  Solver solver(rd);
+  SELFTEST_CHECK(solver.generalSolve(mines));
+  ConfigSampler sampler(solver, mines);
+  SELFTEST_CHECK(sampler.valid());
+
+  std::mt19937 rng(1);
+  vector<vector<int>> mineConf;
+  for (int s = 0; s < 100; ++s) {
+    sampler.sample(mineConf, rng);
+    int placed = 0;
+    for (int i = 0; i < (int) rd.size(); ++i) {
+      for (int j = 0; j < (int) rd[i].size(); ++j)
+        placed += rd[i][j] == CELL_UNDISCOVERED && mineConf[i][j] == 1;
+    }
+    SELFTEST_CHECK(placed == mines);
+    SELFTEST_CHECK(mineConf[0][0] == 1 && mineConf[1][4] == 1);
+  }
+}
+
+// The board of minesweeper.inp. Pairwise crossing leaves (2, 2) open, but the 3
+// is the two 1s plus (2, 2), which eliminate() finds.
+static void testEliminationSettlesCell() {
+  vector<vector<int>> rd = {
+    { 0, 1,-1 },
+    { 1, 3,-1 },
+    {-1,-1,-1 },
+  };
+  Solver solver(rd);
+  SELFTEST_CHECK(solver.generalSolve(3));
+  SELFTEST_CHECK(solver.board.getCell(2, 2)->minePerc == 100.f);
+  SELFTEST_CHECK(solver.solvedCells.contains(solver.board.getCell(2, 2)));
+  SELFTEST_CHECK(solver.stats.cellsEliminated > 0);
+}
+
+// A height x width board with a mine on every cell with probability
+// minePercent / 100 and every safe cell revealed with probability revealPercent /
+// 100, which leaves long, branching chains between the revealed numbers.
+static vector<vector<int>> randomBoard(int height, int width, int minePercent, int revealPercent,
+                                       unsigned seed) {
+  std::mt19937 rng(seed);
+  vector<vector<int>> mine(height, vector<int>(width, 0));
+  for (vector<int>& row : mine) {
+    for (int& m : row)
+      m = (int) (rng() % 100) < minePercent;
+  }
+
+  vector<vector<int>> rd(height, vector<int>(width, CELL_UNDISCOVERED));
+  for (int r = 0; r < height; ++r) {
+    for (int c = 0; c < width; ++c) {
+      if (mine[r][c] || (int) (rng() % 100) >= revealPercent)
+        continue;
+      int n = 0;
+      for (int i = max(r - 1, 0); i <= min(r + 1, height - 1); ++i) {
+        for (int j = max(c - 1, 0); j <= min(c + 1, width - 1); ++j)
+          n += mine[i][j];
+      }
+      rd[r][c] = n;
+    }
+  }
+  return rd;
+}
+
+// Counts of two solutions of the same chain agree, up to rounding.
+static bool sameCounts(const Solver::ChainSolution& a, const Solver::ChainSolution& b) {
+  auto close = [](double x, int sx, double y, int sy) {
+    x = std::ldexp(x, sx);
+    y = std::ldexp(y, sy);
+    return std::fabs(x - y) <= 1e-9 * max(std::fabs(x), std::fabs(y));
+  };
+  if (!(a.relatedCells == b.relatedCells) || a.no_mines != b.no_mines)
+    return false;
+  for (int j = 0; j < (int) a.no_mines.size(); ++j) {
+    if (!close(a.freq_no_mines[j], a.scale, b.freq_no_mines[j], b.scale))
+      return false;
+    for (int c = 0; c < (int) a.relatedCells.size(); ++c) {
+      if (!close(a.freq_mines_pos[j][c], a.scale, b.freq_mines_pos[j][c], b.scale))
+        return false;
+    }
+  }
+  return true;
+}
+
+// countChain() gives the same counts with the frontier sweep as with the enumeration
+// on every chain of a few generated boards.
+static void testFrontierMatchesEnumeration() {
+  int wide = 0;
+  for (unsigned seed = 1; seed <= 8; ++seed) {
+    Solver solver(randomBoard(12, 12, 15, 40, seed));
+    if (!solver.valid_input || !solver.iterativeSolve())
+      continue;
+    for (const vector<Group*>& chain : solver.getGroupChains()) {
+      solver.chainEngine = CHAIN_ENGINE_ENUMERATE;
+      Solver::ChainSolution enumerated = solver.countChain(chain);
+      solver.chainEngine = CHAIN_ENGINE_FRONTIER;
+      SELFTEST_CHECK(sameCounts(enumerated, solver.countChain(chain)));
+      wide += enumerated.relatedCells.size() >= 16;
+    }
+  }
+  SELFTEST_CHECK(wide >= 4);
+}
+
+// Splitting a chain at a cut gives the same counts as the enumeration, on every chain
+// of a few generated boards that has a cut.
+static void testSplitMatchesEnumeration() {
+  int split = 0;
+  for (unsigned seed = 1; seed <= 8; ++seed) {
+    Solver solver(randomBoard(12, 12, 15, 40, seed));
+    if (!solver.valid_input || !solver.iterativeSolve())
+      continue;
+    for (const vector<Group*>& chain : solver.getGroupChains()) {
+      Solver::ChainSolution pieces;
+      if (!solver.solveChainSplit(chain, pieces))
+        continue;
+      split += 1;
+      solver.chainEngine = CHAIN_ENGINE_ENUMERATE;
+      SELFTEST_CHECK(sameCounts(solver.countChain(chain), pieces));
+    }
+  }
+  SELFTEST_CHECK(split >= 4);
+}
+
+// Every cell probability countChain() estimates with the sampler lies within five of
+// its reported standard errors of the exact one.
+static void testApproxWithinErrors() {
+  int cells = 0;
+  for (unsigned seed = 1; seed <= 8; ++seed) {
+    Solver solver(randomBoard(12, 12, 15, 40, seed));
+    if (!solver.valid_input || !solver.iterativeSolve())
+      continue;
+    for (const vector<Group*>& chain : solver.getGroupChains()) {
+      solver.chainEngine = CHAIN_ENGINE_ENUMERATE;
+      Solver::ChainSolution exact = solver.countChain(chain);
+      solver.chainEngine = CHAIN_ENGINE_APPROX;
+      Solver::ChainSolution approx = solver.countChain(chain);
+      SELFTEST_CHECK(approx.approximate && !approx.search.stopped);
+      if (!approx.approximate || approx.search.stopped)
+        continue;
+
+      double exactTotal = 0, approxTotal = 0;
+      for (double f : exact.freq_no_mines)
+        exactTotal += f;
+      for (double f : approx.freq_no_mines)
+        approxTotal += f;
+      for (int c = 0; c < (int) exact.relatedCells.size(); ++c) {
+        double p = 0, q = 0;
+        for (const vector<double>& freq : exact.freq_mines_pos)
+          p += freq[c];
+        for (const vector<double>& freq : approx.freq_mines_pos)
+          q += freq[c];
+        double deviation = std::fabs(p / exactTotal - q / approxTotal) * 100;
+        SELFTEST_CHECK(deviation <= 5 * approx.error[c] + 1e-3);
+        cells += 1;
+      }
+    }
+  }
+  SELFTEST_CHECK(cells > 0);
+}
+
+int runSelfTest() {
+  failures = 0;
+  testCellSetErase();
+  testSessionGroupLosesHighWord();
+  testSamplerWithFlag();
+  testEliminationSettlesCell();
+  testFrontierMatchesEnumeration();
+  testSplitMatchesEnumeration();
+  testApproxWithinErrors();
+  printf("%s (%d failed checks)\n", failures == 0 ? "OK" : "FAILED", failures);
+  return failures;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Regression checks of the solver internals, each printing a line per failure.
+// Returns the number of failed checks. Run with
+//   MinesweeperSolver
+// when built with BUILD_SELFTEST defined.
+int runSelfTest();
@@ -0,0 +1,28 @@
+#include "SolveBudget.h"
+
+SolveBudget::SolveBudget(const SolveOptions& options) : options(options), spent(0), state(SOLVE_STATUS_COMPLETE) {
+  auto limit = std::chrono::duration<double, std::milli>(options.timeLimitMs);
+  deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(limit);
+}
+
+// Adds nodes to the work done so far and checks every limit. Returns true if the
+// solve has to stop.
+bool SolveBudget::charge(uint64_t nodes) {
+  if (exhausted())
+    return true;
+
+  uint64_t total = spent.fetch_add(nodes, std::memory_order_relaxed) + nodes;
+  int next = SOLVE_STATUS_COMPLETE;
+  if (options.cancel && options.cancel->load(std::memory_order_relaxed))
+    next = SOLVE_STATUS_CANCELLED;
+  else if (options.nodeLimit > 0 && total > options.nodeLimit)
+    next = SOLVE_STATUS_OUT_OF_NODES;
+  else if (options.timeLimitMs > 0 && std::chrono::steady_clock::now() >= deadline)
+    next = SOLVE_STATUS_TIMED_OUT;
+
+  if (next == SOLVE_STATUS_COMPLETE)
+    return false;
+  int expected = SOLVE_STATUS_COMPLETE;
+  state.compare_exchange_strong(expected, next, std::memory_order_relaxed);
+  return true;
+}
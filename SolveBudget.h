@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Macros.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Limits for one generalSolve() / solveEndgame() call. Zero means no limit.
+struct SolveOptions {
+  double timeLimitMs;
+  uint64_t nodeLimit;               // search nodes over all chains and endgame states
+  const std::atomic<bool>* cancel;  // polled; set it from another thread to stop the solve
+
+  SolveOptions() : timeLimitMs(0), nodeLimit(0), cancel(nullptr) {}
+};
+
+// The running budget of a solve, shared by every thread working on it. Hot loops
+// count their nodes locally and charge() them in batches of BUDGET_POLL_INTERVAL;
+// once the budget is exhausted it stays exhausted and every search unwinds.
+class SolveBudget {
+public:
+  explicit SolveBudget(const SolveOptions& options);
+  SolveBudget(const SolveBudget&) = delete;
+  SolveBudget& operator=(const SolveBudget&) = delete;
+
+  bool charge(uint64_t nodes);
+  bool exhausted() const { return state.load(std::memory_order_relaxed) != SOLVE_STATUS_COMPLETE; }
+  int status() const { return state.load(std::memory_order_relaxed); } // SOLVE_STATUS_*
+
+private:
+  SolveOptions options;
+  std::chrono::steady_clock::time_point deadline;
+  std::atomic<uint64_t> spent;
+  std::atomic<int> state;
+};
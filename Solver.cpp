@@ -1,36 +1,5 @@
 #include "Solver.h"
-#if defined(_MSC_VER) && !defined(__clang__)
-#include <intrin.h>
-#endif
-
-// Returns all binary vectors of length n with exactly r ones,
-// using popcount for fast bitmask enumeration. Results are cached per (n, r).
-vector<vector<int>> Solver::getCombinations(int n, int r) const {
-  uint32_t key = ((uint32_t)n << 16) | (uint32_t)r;
-  auto it = combinationCache.find(key);
-  if (it != combinationCache.end())
-    return it->second;
-
-  vector<vector<int>> out;
-  for (int i = 0; i < (1 << n); ++i) {
-#if defined(_MSC_VER) && !defined(__clang__)
-    int pc = __popcnt(i);
-#else
-    int pc = __builtin_popcount(i);
-#endif
-    if (pc == r) {
-      vector<int> row;
-      int t = i;
-      for (int j = 0; j < n; ++j) {
-        row.push_back(t & 1);
-        t >>= 1;
-      }
-      out.push_back(row);
-    }
-  }
-  combinationCache[key] = out;
-  return out;
-}
+#include "ConfigSampler.h"
 
 // Computes n-choose-r (binomial coefficient), clamped to an upper bound to prevent overflow.
 static uint64_t bounded_nCr(uint16_t n, uint16_t r, uint64_t bound = -1) {
@@ -46,8 +15,36 @@ static uint64_t bounded_nCr(uint16_t n, uint16_t r, uint64_t bound = -1) {
 // Constructs the solver from a 2D board representation. Initializes groups from
 // numbered cells, builds the popcount lookup table, and identifies cells with no
 // numbered neighbors (used for remaining-mine probability calculations).
-Solver::Solver(vector<vector<int>> rd) : board(rd) {
+Solver::Solver(vector<vector<int>> rd) : board(rd), solvedCells(&board) {
+  TRACE_SCOPE("Solver::Solver");
+  chainEngine = CHAIN_ENGINE_AUTO;
+  approxMinCells = APPROX_MIN_CELLS;
+  approxTimeMs = APPROX_TIME_MS;
+  init();
+}
+
+// Loads a new board into this solver. All groups of the previous board are freed
+// in bulk, while the group pool keeps its storage for the new one.
+void Solver::reset(vector<vector<int>> rd) {
+  TRACE_SCOPE("Solver::reset");
+  groups.clear();
+  crossQueue.clear();
+  syncQueue.clear();
+  applyQueue.clear();
+  newlySolved.clear();
+  groupIndex.clear();
+  noNeighbors.clear();
+  pool.reset();
+
+  board = Board(rd);
+  solvedCells = CellSet(&board);
+  stats.clear();
+  init();
+}
+
+void Solver::init() {
   valid_input = true;
+  nextSerial = 0;
   for (int i = 0; i < board.height; ++i) {
     for (int j = 0; j < board.width; ++j) {
       Cell* c = board.getCellMutable(i, j);
@@ -55,9 +52,11 @@ Solver::Solver(vector<vector<int>> rd) : board(rd) {
         c->minePerc = 0;
         continue;
       }
-      Group* group = new Group(i, j, board);
-      if (group->minV == 0 && group->maxV == 0 && group->groupcells.size() == 0)
+      Group* group = pool.create(i, j, board);
+      if (group->minV == 0 && group->maxV == 0 && group->groupcells.size() == 0) {
+        pool.release(group);
         continue;
+      }
       if (group->maxV < 0 || group->minV > group->groupcells.size())
         valid_input = false;
       if (board.data.size() != (size_t) 0)
@@ -66,47 +65,107 @@ Solver::Solver(vector<vector<int>> rd) : board(rd) {
   }
   solved = false;
   canEndgame = false;
+  numConfigurations = 0;
 
   noNeighbors = board.noNeighborsCells();
+}
 
-  for (int i = 0; i < board.height; ++i) {
-    for (int j = 0; j < board.width; ++j) {
-      Cell* c = board.getCellMutable(i, j);
-      if (!c->groups.empty())
-        groupedCells.push_back(c);
+// Assigns an ID to the group, appends it to the solver's group list and queues
+// it for propagation. If a live group over the same cells already exists, the new
+// bounds are merged into it instead and the new group is released; a merge that
+// would be contradictory is left for syncAllGroups() to report. Returns the group
+// that now holds the constraint.
+Group* Solver::addGroup(Group* g) {
+  size_t key = g->groupcells.hash();
+  auto range = groupIndex.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    Group* existing = it->second;
+    if (existing->disabled || !(existing->groupcells == g->groupcells))
+      continue;
+
+    int minV = max(existing->minV, g->minV);
+    int maxV = min(existing->maxV, g->maxV);
+    if (minV > maxV)
+      break;
+
+    if (minV != existing->minV || maxV != existing->maxV) {
+      existing->minV = minV;
+      existing->maxV = maxV;
+      queueGroup(existing);
     }
+    g->cellUnsync();
+    pool.release(g);
+    stats.groupsMerged += 1;
+    return existing;
   }
-}
 
-// Assigns an ID to the group and appends it to the solver's group list.
-void Solver::addGroup(Group* g) {
   g->id = (int) groups.size();
+  g->serial = nextSerial++;
+  stats.groupsCreated += 1;
   groups.push_back(g);
+  groupIndex.emplace(key, g);
+  queueGroup(g);
+  return g;
 }
 
-// For every cell belonging to multiple groups, crosses (splits) overlapping group
-// pairs to produce new refined sub-groups with tighter mine-count constraints.
+// Queues a group that was created or tightened so that the next crossAllGroups()
+// and syncAllGroups() passes look at it again.
+void Solver::queueGroup(Group* g) {
+  if (!g->pendingCross) {
+    g->pendingCross = true;
+    crossQueue.push_back(g);
+  }
+  if (!g->pendingSync) {
+    g->pendingSync = true;
+    syncQueue.push_back(g);
+  }
+}
+
+// Crosses (splits) every group queued since the last pass with each live group it
+// overlaps, producing refined sub-groups with tighter mine-count constraints.
+// Pairs of groups that were both unchanged since the last pass are skipped, as
+// crossing them again would only reproduce groups that already exist. Groups
+// created here are crossed on the next pass.
 void Solver::crossAllGroups() {
+  TRACE_SCOPE("crossAllGroups");
   int maxGroupId = (int) groups.size();
+  vector<Group*> batch;
+  batch.swap(crossQueue);
+
+  // 1: queued, 2: already crossed with all its neighbours in this pass
+  vector<char> state(maxGroupId, 0);
+  vector<int> seen(maxGroupId, -1);
+  for (Group* g : batch) {
+    g->pendingCross = false;
+    state[g->id] = 1;
+  }
 
-  for (Cell* c : groupedCells) {
-    if (c->groups.size() <= 1)
+  for (Group* g : batch) {
+    if (g->disabled)
       continue;
-    int n = (int) c->groups.size();
-    for (int x = 0; x < n - 1; ++x) {
-      if (c->groups[x]->disabled)
-        continue;
-      if (c->groups[x]->id >= maxGroupId)
-        continue;
-      for (int y = x+1; y < n; ++y) {
-        if (c->groups[y]->disabled)
+    state[g->id] = 2;
+    seen[g->id] = g->id;
+
+    for (Cell* c : g->groupcells) {
+      for (int k = 0; k < (int) c->groups.size(); ++k) {
+        Group* h = c->groups[k];
+        if (h->disabled || h->id >= maxGroupId)
           continue;
-        if (c->groups[y]->id >= maxGroupId)
+        if (seen[h->id] == g->id || state[h->id] == 2)
           continue;
-
-        vector<Group*> newGroups = c->groups[x]->cross((*c->groups[y]));
-        for (Group* g : newGroups)
-          addGroup(g);
+        seen[h->id] = g->id;
+
+        int gMin = g->minV, gMax = g->maxV;
+        int hMin = h->minV, hMax = h->maxV;
+        vector<Group*> newGroups = g->cross(*h, pool);
+        stats.crossCalls += 1;
+        for (Group* ng : newGroups)
+          addGroup(ng);
+
+        if (g->minV != gMin || g->maxV != gMax)
+          queueGroup(g);
+        if (h->minV != hMin || h->maxV != hMax)
+          queueGroup(h);
       }
     }
   }
@@ -128,6 +187,16 @@ void Solver::filterTrivial() {
 // master group list. Disabled groups are swapped to the back and popped off, and
 // remaining group IDs are reassigned to stay contiguous.
 void Solver::cleanDisabled() {
+  vector<Group*>* queues[] = { &crossQueue, &syncQueue, &applyQueue };
+  for (vector<Group*>* q : queues) {
+    int kept = 0;
+    for (Group* g : *q) {
+      if (!g->disabled)
+        (*q)[kept++] = g;
+    }
+    q->resize(kept);
+  }
+
   for (int i = 0; i < board.height; ++i) {
     for (int j = 0; j < board.width; ++j) {
       Cell* c = board.getCellMutable(i, j);
@@ -174,16 +243,23 @@ void Solver::cleanDisabled() {
   while (groups.size() > 0 && groups.back()->disabled) {
     Group* g = groups.back();
     groups.pop_back();
-    delete g;
+    pool.release(g);
+    stats.groupsReleased += 1;
   }
+
+  groupIndex.clear();
+  for (Group* g : groups)
+    groupIndex.emplace(g->groupcells.hash(), g);
 }
 
 // Marks cells as definitively safe or mined when a group's constraint is fully
 // determined (minV == maxV == 0 means all safe, minV == maxV == size means all mines).
+// Only groups that syncAllGroups() queued since the last call are checked; a group
+// that is determined gets applied the first time it is created or tightened.
 // Returns true if any cells were resolved.
 bool Solver::apply() {
   bool reduced = false;
-  for (Group* g : groups) {
+  for (Group* g : applyQueue) {
     if (!(g->minV == g->maxV && (g->maxV == g->groupcells.size() || g->maxV == 0)))
       continue;
     if (g->disabled)
@@ -192,33 +268,202 @@ bool Solver::apply() {
     for (Cell* c : g->groupcells) {
       c->value = g->minV == 0 ? CELL_SAFE : CELL_FLAG;
       c->minePerc = g->minV == 0 ? 0.f : 100.f;
-      solvedCells.insert(c);
+      if (!solvedCells.contains(c)) {
+        solvedCells.insert(c);
+        newlySolved.push_back(c);
+      }
     }
   }
+  applyQueue.clear();
   return reduced;
 }
 
-// Propagates constraints between overlapping groups sharing cells by merging
-// their min/max bounds. Returns false if a contradiction is detected.
+// Merges the min/max bounds of every queued group with the live groups covering
+// exactly the same cells, disabling the duplicates. Equal groups share their first
+// cell, so only that cell's group list has to be scanned. Processed groups are
+// handed to apply(). Returns false if a contradiction is detected.
 bool Solver::syncAllGroups() {
-  for (Cell* c : groupedCells) {
-    if (c->groups.size() <= 1)
+  TRACE_SCOPE("syncAllGroups");
+  while (!syncQueue.empty()) {
+    Group* g = syncQueue.back();
+    syncQueue.pop_back();
+    g->pendingSync = false;
+    if (g->disabled)
+      continue;
+
+    applyQueue.push_back(g);
+    if (g->groupcells.empty())
       continue;
-    int n = (int) c->groups.size();
-    for (int i = 0; i < n-1; ++i) {
-      if (c->groups[i]->disabled)
+
+    int gMin = g->minV, gMax = g->maxV;
+    Cell* first = *g->groupcells.begin();
+    for (Group* h : first->groups) {
+      if (h == g || h->disabled)
         continue;
-      for (int j = i + 1; j < n; ++j) {
-        if (c->groups[j]->disabled)
-          continue;
+      if (!(h->groupcells == g->groupcells))
+        continue;
+
+      bool valid = g->merge(*h);
+      if (!valid)
+        return false;
+    }
+
+    if ((g->minV != gMin || g->maxV != gMax) && !g->pendingCross) {
+      g->pendingCross = true;
+      crossQueue.push_back(g);
+    }
+  }
+
+  return true;
+}
+
+// Reduces one connected set of exact groups, m[row] = coefficients of its cells
+// followed by the mine count, to reduced row echelon form with integer row
+// operations. Every reduced row a.x = b is then bounded: with x in {0, 1}, a.x ranges
+// over [lo, hi], so a cell whose |a| exceeds b - lo or hi - b has only one value left.
+// forced[cell] gets 0 or 1 for those. Returns false on a contradiction; gives up
+// without deducing anything if coefficients grow too large.
+static bool eliminateComponent(vector<vector<int64_t>>& m, vector<int>& forced) {
+  int nRows = (int) m.size();
+  int nCols = (int) forced.size();
+  const int64_t limit = (int64_t) 1 << 30;
+
+  int rank = 0;
+  for (int c = 0; c < nCols && rank < nRows; ++c) {
+    int p = rank;
+    while (p < nRows && m[p][c] == 0)
+      p += 1;
+    if (p == nRows)
+      continue;
+    std::swap(m[rank], m[p]);
+
+    const vector<int64_t>& pivot = m[rank];
+    for (int r = 0; r < nRows; ++r) {
+      if (r == rank || m[r][c] == 0)
+        continue;
+      int64_t a = pivot[c], b = m[r][c];
+      int64_t g = 0;
+      for (int k = 0; k <= nCols; ++k) {
+        m[r][k] = a * m[r][k] - b * pivot[k];
+        g = std::gcd(g, m[r][k]);
+      }
+      if (g > 1) {
+        for (int k = 0; k <= nCols; ++k)
+          m[r][k] /= g;
+      }
+      for (int k = 0; k <= nCols; ++k) {
+        if (m[r][k] >= limit || m[r][k] <= -limit)
+          return true;
+      }
+    }
+    rank += 1;
+  }
+
+  for (int r = 0; r < nRows; ++r) {
+    int64_t lo = 0, hi = 0, b = m[r][nCols];
+    for (int k = 0; k < nCols; ++k)
+      (m[r][k] < 0 ? lo : hi) += m[r][k];
+    if (b < lo || b > hi)
+      return false;
 
-        bool valid = c->groups[i]->merge(*(c->groups[j]));
-        if (!valid)
+    for (int k = 0; k < nCols; ++k) {
+      int64_t a = m[r][k];
+      if (a == 0)
+        continue;
+      int value = -1;
+      if (std::abs(a) > b - lo)
+        value = a > 0 ? 0 : 1;
+      if (std::abs(a) > hi - b) {
+        if (value == (a > 0 ? 0 : 1))
           return false;
+        value = a > 0 ? 1 : 0;
       }
+      if (value < 0)
+        continue;
+      if (forced[k] >= 0 && forced[k] != value)
+        return false;
+      forced[k] = value;
+    }
+  }
+  return true;
+}
+
+// Deduction beyond pairwise crossing: every group with an exact mine count is a
+// linear equation over its cells, and the equations of every connected set of such
+// groups are eliminated together (see eliminateComponent). Sets of more than
+// ELIMINATION_MAX_CELLS cells are skipped. Every cell this settles becomes a
+// single-cell group, so the following sync/apply/filter steps resolve it like any
+// other determined group. Returns false if the equations contradict each other.
+bool Solver::eliminate() {
+  TRACE_SCOPE("eliminate");
+  vector<Group*> rows;
+  vector<Cell*> cells;
+  unordered_map<int, int> column; // cell id -> index in cells
+  for (Group* g : groups) {
+    if (g->disabled || g->minV != g->maxV)
+      continue;
+    rows.push_back(g);
+    for (Cell* c : g->groupcells) {
+      if (column.emplace(c->id, (int) cells.size()).second)
+        cells.push_back(c);
     }
   }
 
+  // Connected sets of cells, joined by the groups over them
+  vector<int> parent(cells.size());
+  for (int i = 0; i < (int) parent.size(); ++i)
+    parent[i] = i;
+  auto root = [&](int i) {
+    while (parent[i] != i)
+      i = parent[i] = parent[parent[i]];
+    return i;
+  };
+  for (Group* g : rows) {
+    int first = root(column[(*g->groupcells.begin())->id]);
+    for (Cell* c : g->groupcells)
+      parent[root(column[c->id])] = first;
+  }
+
+  vector<vector<int>> componentRows(cells.size());
+  vector<vector<int>> componentCells(cells.size());
+  for (int r = 0; r < (int) rows.size(); ++r)
+    componentRows[root(column[(*rows[r]->groupcells.begin())->id])].push_back(r);
+  for (int i = 0; i < (int) cells.size(); ++i)
+    componentCells[root(i)].push_back(i);
+
+  vector<int> local(cells.size());
+  for (int comp = 0; comp < (int) cells.size(); ++comp) {
+    // A single group is already settled by apply() if it can be
+    int nRows = (int) componentRows[comp].size();
+    int nCols = (int) componentCells[comp].size();
+    if (nRows < 2 || nCols > ELIMINATION_MAX_CELLS)
+      continue;
+
+    for (int k = 0; k < nCols; ++k)
+      local[componentCells[comp][k]] = k;
+    vector<vector<int64_t>> m(nRows, vector<int64_t>(nCols + 1, 0));
+    for (int r = 0; r < nRows; ++r) {
+      Group* g = rows[componentRows[comp][r]];
+      for (Cell* c : g->groupcells)
+        m[r][local[column[c->id]]] = 1;
+      m[r][nCols] = g->minV;
+    }
+
+    vector<int> forced(nCols, -1);
+    if (!eliminateComponent(m, forced))
+      return false;
+
+    for (int k = 0; k < nCols; ++k) {
+      if (forced[k] < 0)
+        continue;
+      CellSet single(&board);
+      single.insert(cells[componentCells[comp][k]]);
+      Group* g = pool.create(single);
+      g->minV = g->maxV = forced[k];
+      addGroup(g);
+      stats.cellsEliminated += 1;
+    }
+  }
   return true;
 }
 
@@ -228,9 +473,15 @@ bool Solver::isDone() const {
 }
 
 // Repeatedly crosses groups, syncs constraints, and applies deterministic deductions
-// until no more progress can be made. Returns false if a contradiction is found.
-bool Solver::iterativeSolve() {
+// until no more progress can be made, then tries eliminate() and carries on with
+// whatever it settled. Each step only revisits the groups queued since the previous
+// one. Returns false if a contradiction is found.
+bool Solver::iterativeSolve(SolveBudget* budget) {
+  TRACE_SCOPE("iterativeSolve");
   while (!isDone()) {
+    if (budget && budget->charge(1))
+      break;
+    stats.iterativeRounds += 1;
     crossAllGroups();
     int iter = 0;
     while (1) {
@@ -245,90 +496,149 @@ bool Solver::iterativeSolve() {
       if (!valid)
         return false;
     }
-    if (iter == 0)
-      break;
+    if (iter == 0) {
+      if (!eliminate())
+        return false;
+      if (syncQueue.empty())
+        break;
+    }
   }
   filterTrivial();
   cleanDisabled();
   return true;
 }
 
-// Recursively combines mine-count distributions from independent chains via a
-// Cartesian product. Builds a 2D table (mines[totalMines][chainSlot]) tracking
-// the weighted frequency of each total mine count across all chain combinations.
-static vector<int> s_chain_index;
-static vector<int> s_local_index;
-
-void combineChainMineCount(const vector<Solver::ChainSolution>& chain_sols, vector<vector<int>>& mines,
-                           vector<int>& offset, vector<int>& config, int& minMines, int id = 0) {
-  if (id == 0) {
-    mines.clear();
-    offset.clear();
-    config.clear();
-    int maxMines = 0;
-    int c = 0;
-    minMines = 0;
-    for (const Solver::ChainSolution& cs : chain_sols) {
-      maxMines += cs.no_mines.back();
-      minMines += cs.no_mines.front();
-      offset.push_back(c);
-      c += (int) cs.no_mines.size();
-    }
-    mines = vector<vector<int>>(maxMines + 1 - minMines, vector<int>(c, 0));
-    config = vector<int>(c, 0);
-
-    s_chain_index.resize(c);
-    s_local_index.resize(c);
-    for (int ci = 0; ci < (int) chain_sols.size(); ++ci) {
-      int len = (int) chain_sols[ci].no_mines.size();
-      for (int li = 0; li < len; ++li) {
-        s_chain_index[offset[ci] + li] = ci;
-        s_local_index[offset[ci] + li] = li;
-      }
-    }
+// Multiplies two mine-count polynomials (index = number of mines).
+static vector<double> convolveMineCounts(const vector<double>& a, const vector<double>& b) {
+  vector<double> out(a.size() + b.size() - 1, 0);
+  for (int i = 0; i < (int) a.size(); ++i) {
+    if (a[i] == 0)
+      continue;
+    for (int j = 0; j < (int) b.size(); ++j)
+      out[i + j] += a[i] * b[j];
   }
+  return out;
+}
 
-  if (id == (int) chain_sols.size()) {
-    int sumMines = 0;
-    int weight = 1;
-    int n = (int) config.size();
-    for (int i = 0; i < n; ++i) {
-      if (config[i] == 0)
-        continue;
-      weight *= config[i];
-      sumMines += chain_sols[s_chain_index[i]].no_mines[s_local_index[i]];
-    }
+// Combines the mine-count distributions of independent chains. Chain ci with
+// no_mines[j] mines owns the slot offset[ci] + j; mines[k][slot] is the weighted
+// number of ways all chains together hold k + minMines mines with that slot picked,
+// and weight[k] the weighted number of ways overall, both times 2^-scale. Each chain
+// is a polynomial in its mine count, so the slots of chain ci follow from the
+// product of the chains before it (prefix) and after it (suffix) instead of a
+// Cartesian product. Every product is renormalized, so that any number of chains
+// can be combined without leaving the range of a double.
+static void combineChainMineCount(const vector<Solver::ChainSolution>& chain_sols, vector<vector<double>>& mines,
+                                  vector<double>& weight, int& scale, vector<int>& offset, int& minMines) {
+  TRACE_SCOPE("combineChainMineCount");
+  int C = (int) chain_sols.size();
+  offset.clear();
+  minMines = 0;
+  int maxMines = 0;
+  int c = 0;
+  vector<vector<double>> poly(C);
+  vector<int> polyScale(C);
+  for (int ci = 0; ci < C; ++ci) {
+    const Solver::ChainSolution& cs = chain_sols[ci];
+    maxMines += cs.no_mines.back();
+    minMines += cs.no_mines.front();
+    offset.push_back(c);
+    c += (int) cs.no_mines.size();
+
+    poly[ci].assign(cs.no_mines.back() - cs.no_mines.front() + 1, 0);
+    for (int j = 0; j < (int) cs.no_mines.size(); ++j)
+      poly[ci][cs.no_mines[j] - cs.no_mines.front()] = cs.freq_no_mines[j];
+    polyScale[ci] = cs.scale + normalizeCounts(poly[ci]);
+  }
 
-    for (int i = 0; i < n; ++i) {
-      if (config[i] == 0)
-        continue;
-      mines[sumMines - minMines][i] += weight;
+  vector<vector<double>> suffix(C + 1);
+  vector<int> suffixScale(C + 1, 0);
+  suffix[C] = vector<double>(1, 1);
+  for (int ci = C - 1; ci >= 0; --ci) {
+    suffix[ci] = convolveMineCounts(poly[ci], suffix[ci + 1]);
+    suffixScale[ci] = polyScale[ci] + suffixScale[ci + 1] + normalizeCounts(suffix[ci]);
+  }
+  weight = suffix[0];
+  scale = suffixScale[0];
+
+  mines.assign(maxMines + 1 - minMines, vector<double>(c, 0));
+  vector<double> prefix(1, 1);
+  int prefixScale = 0;
+  for (int ci = 0; ci < C; ++ci) {
+    const Solver::ChainSolution& cs = chain_sols[ci];
+    vector<double> rest = convolveMineCounts(prefix, suffix[ci + 1]);
+    double factor = std::ldexp(1., cs.scale + prefixScale + suffixScale[ci + 1] - scale);
+    for (int j = 0; j < (int) cs.no_mines.size(); ++j) {
+      int shift = cs.no_mines[j] - cs.no_mines.front();
+      for (int k = 0; k < (int) rest.size(); ++k)
+        mines[shift + k][offset[ci] + j] += cs.freq_no_mines[j] * rest[k] * factor;
     }
-    return;
+    prefix = convolveMineCounts(prefix, poly[ci]);
+    prefixScale += polyScale[ci] + normalizeCounts(prefix);
   }
+}
 
-  const Solver::ChainSolution& cs = chain_sols[id];
-  int n = (int) cs.no_mines.size();
-  for (int i = 0; i < n; ++i) {
-    config[i + offset[id]] = cs.freq_no_mines[i];
-    combineChainMineCount(chain_sols, mines, offset, config, minMines, id + 1);
-    config[i + offset[id]] = 0;
+// Combines the mine counts of ctx.chain_sols and weighs every possible number of
+// mines in the chains against the cells outside of them, given the number of mines
+// left on the board. Returns false if no split of the mines is possible. When every
+// possible count has zero weight, noMinesProb is left at zero.
+bool Solver::weighChains(int mines, SolveContext& ctx) const {
+  combineChainMineCount(ctx.chain_sols, ctx.cmines, ctx.weight, ctx.weightScale, ctx.offset, ctx.minMines);
+  int minMines = ctx.minMines;
+
+  int low = 0, high = (int) ctx.cmines.size() - 1;
+  if (high + minMines > mines)
+    high = mines - minMines;
+
+  if (mines - (low + minMines) > (int) noNeighbors.size())
+    low = mines - (int) noNeighbors.size() - minMines;
+
+  if (low > high || low < 0 || high < 0)
+    return false;
+  ctx.low = low;
+  ctx.high = high;
+
+  ctx.noMinesProb.assign(high - low + 1, 0.);
+  ctx.totalWeight = 0;
+  for (int i = low; i <= high; ++i)
+    ctx.totalWeight += ctx.weight[i];
+  if (ctx.totalWeight == 0)
+    return true;
+
+  vector<int> remaining_mines(high - low + 1);
+  vector<double> weight_slice(high - low + 1);
+  for (int i = low; i <= high; ++i) {
+    remaining_mines[i - low] = mines - (i + minMines);
+    weight_slice[i - low] = ctx.weight[i];
   }
+
+  vector<double> p = computeNormalizedBinomials(noNeighbors.size(), remaining_mines, weight_slice);
+  for (int i = 0; i <= high - low; ++i)
+    ctx.noMinesProb[i] = p[i];
+  return true;
 }
 
 // Main entry point: runs deterministic deduction first, then if the total mine count
 // is known, enumerates valid configurations per chain and computes per-cell mine
 // probabilities using Bayesian weighting over remaining unassigned mines.
-bool Solver::generalSolve(int mines) { // number of unsolved mines (flags in the input do not count)
+// If the budget runs out, the deductions made so far are kept, every other
+// unknown cell is left unpredicted (minePerc -1) and true is returned; the
+// budget's status() tells whether the result is complete.
+bool Solver::generalSolve(int mines, SolveBudget* budget) { // number of unsolved mines (flags in the input do not count)
+  TRACE_SCOPE("generalSolve");
   if (!valid_input)
     return false;
 
-  bool valid = iterativeSolve();
+  bool valid = iterativeSolve(budget);
   if (!valid)
     return false;
 
   if (mines == -1)
     return true;
+  if (budget && budget->exhausted()) {
+    markUnresolved();
+    return true;
+  }
 
   for (Cell* solved_cell : solvedCells)
     mines -= (solved_cell->minePerc == 100.);
@@ -336,53 +646,27 @@ bool Solver::generalSolve(int mines) { // number of unsolved mines (flags in the
   if (mines < 0)
     return false;
 
+  SolveContext ctx;
   vector<vector<Group*>> chains = getGroupChains();
-  vector<Solver::ChainSolution> chain_sols;
-  for (const vector<Group*>& g : chains)
-    chain_sols.push_back(solveChain(g));
-
-  vector<vector<int>> cmines;
-  vector<int> offset;
-  vector<int> config;
-  int minMines;
-  combineChainMineCount(chain_sols, cmines, offset, config, minMines);
-  vector<int> weight(cmines.size(), 0);
-  int l = offset.size() <= 1 ? (int) config.size() : offset[1];
-  for (int i = 0; i < cmines.size(); ++i) {
-    for (int j = 0; j < l; ++j)
-      weight[i] += cmines[i][j];
-    //
-  }
-
-  int low = 0, high = (int) cmines.size()-1;
-  if (high + minMines > mines)
-    high = mines - minMines;
-
-  if (mines - (low + minMines) > noNeighbors.size())
-    low = mines - noNeighbors.size() - minMines;
-
-  if (low > high || low < 0 || high < 0)
+  ctx.chain_sols = reuseOrSolveChains(chains, budget);
+  if (ctx.chain_sols.size() != chains.size()) {
+    markUnresolved();
+    return true;
+  }
+  if (!weighChains(mines, ctx))
     return false;
 
-  vector<double> noMinesProb(high - low + 1, 0.);
-  int sumW = 0;
-  for (int i = low; i <= high; ++i)
-    sumW += weight[i];
+  const vector<Solver::ChainSolution>& chain_sols = ctx.chain_sols;
+  const vector<vector<double>>& cmines = ctx.cmines;
+  const vector<int>& offset = ctx.offset;
+  const vector<double>& noMinesProb = ctx.noMinesProb;
+  vector<double>& weight = ctx.weight;
+  int minMines = ctx.minMines;
+  int low = ctx.low, high = ctx.high;
 
-  if (sumW == 0)
+  if (ctx.totalWeight == 0)
     weight[0] = 1;
   else {
-    vector<int> remaining_mines(high - low + 1);
-    vector<int> weight_slice(high - low + 1);
-    for (int i = low; i <= high; ++i) {
-      remaining_mines[i - low] = mines - (i + minMines);
-      weight_slice[i - low] = weight[i];
-    }
-
-    vector<double> p = computeNormalizedBinomials(noNeighbors.size(), remaining_mines, weight_slice);
-    for (int i = 0; i <= high - low; ++i)
-      noMinesProb[i] = p[i];
-
     int idx = 0;
     for (const Solver::ChainSolution& cs : chain_sols) {
       int nCells = cs.relatedCells.size();
@@ -393,13 +677,14 @@ bool Solver::generalSolve(int mines) { // number of unsolved mines (flags in the
         for (int k = low; k <= high; ++k) {
           double imProb = 0;
           for (int j = 0; j < nV; ++j) {
-            double p1 = 1.*cs.freq_mines_pos[j][i] / cs.freq_no_mines[j];
-            double p2 = 1.*cmines[k][j+offset[idx]] / weight[k];
+            double p1 = cs.freq_mines_pos[j][i] / cs.freq_no_mines[j];
+            double p2 = cmines[k][j+offset[idx]] / weight[k];
             imProb += p1*p2;
           }
           prob += imProb * noMinesProb[k-low];
         }
         c->minePerc = prob*100;
+        c->minePercErr = cs.approximate ? cs.error[i] : 0.f;
         i += 1;
       }
       idx += 1;
@@ -413,25 +698,30 @@ bool Solver::generalSolve(int mines) { // number of unsolved mines (flags in the
   for (Cell* c : noNeighbors)
     c->minePerc = expectedRemain / noNeighbors.size() * 100;
 
-  // Check endgame eligibility
+  // Check endgame eligibility; sampled chains only have estimated counts
   int totalUnrevealedCells = 0;
-  for (const Solver::ChainSolution& cs : chain_sols)
+  bool sampled = false;
+  for (const Solver::ChainSolution& cs : chain_sols) {
     totalUnrevealedCells += (int)cs.relatedCells.size();
+    sampled |= cs.approximate;
+  }
   totalUnrevealedCells += (int)noNeighbors.size();
 
   canEndgame = false;
-  if (totalUnrevealedCells <= MAX_ENDGAME_CELLS) {
-    const uint64_t bound = 100000;
+  numConfigurations = 0;
+  if (totalUnrevealedCells <= MAX_ENDGAME_CELLS && !sampled) {
+    const uint64_t bound = CONFIG_COUNT_BOUND;
     uint64_t numberOfConfiguration = 0;
     for (int numMines = low; numMines <= high; ++numMines) {
-      uint64_t nConfig = weight[numMines] * bounded_nCr(noNeighbors.size(), mines - (numMines + minMines), bound);
-      numberOfConfiguration += nConfig;
+      double nConfig = std::ldexp(weight[numMines], ctx.weightScale) *
+                       bounded_nCr(noNeighbors.size(), mines - (numMines + minMines), bound);
+      numberOfConfiguration += (uint64_t) min(std::round(nConfig), (double) bound);
       if (numberOfConfiguration >= bound) {
         numberOfConfiguration = bound;
         break;
       }
     }
-    std::cout << "Number of configurations: " << numberOfConfiguration << (numberOfConfiguration == bound ? "+" : "") << std::endl;
+    numConfigurations = numberOfConfiguration;
     canEndgame = (numberOfConfiguration > 0 && numberOfConfiguration <= MAX_ENDGAME_CONFIGS);
   }
 
@@ -481,6 +771,7 @@ void Solver::printProb() const {
 // Two groups are connected if they share at least one cell. Each chain can be
 // solved independently, reducing the combinatorial search space.
 vector<vector<Group*>> Solver::getGroupChains() const {
+  TRACE_SCOPE("getGroupChains");
   vector<vector<Group*>> out;
   int n = (int) groups.size();
   vector<bool> added(n, false);
@@ -517,139 +808,228 @@ vector<vector<Group*>> Solver::getGroupChains() const {
   return out;
 }
 
-// Recursively enumerates all valid mine assignments for a chain of groups. Processes
-// groups in the given order, trying each valid combination for unassigned cells and
-// pruning branches that violate group constraints. Accumulates configuration counts
-// and per-cell mine frequencies indexed by total mine count.
-void Solver::solveRec(const vector<Group*>& chain, const vector<int>& order,
-                      const vector<vector<int>>& group_cells_id, vector<int>& freq_no_mines,
-                      vector<vector<int>>& freq_mines_pos, vector<int>& sol, vector<vector<int>>& all_configs, int id) const {
-  if (id == order.size()) {
-    int sumMines = 0;
-    for (int v : sol)
-      sumMines += v;
-    all_configs.push_back(sol);
-    freq_no_mines[sumMines] += 1;
-    int i = 0;
-    for (int v : sol)
-      freq_mines_pos[sumMines][i++] += v;
-    return;
+static_assert(MAX_GROUP_CELLS <= 8, "group masks are stored as uint8_t");
+
+// Tables over the fillings of a group's unassigned cells, for n up to
+// MAX_GROUP_CELLS cells, built at compile time. masks[start[n][k]] to
+// masks[start[n][k + 1] - 1] are the masks of n cells with k mines, in increasing
+// order, and ways[n][lo][hi] is the number of ways to put between lo and hi mines
+// in n cells.
+struct GroupFillings {
+  uint8_t masks[(2 << MAX_GROUP_CELLS) - 1];
+  int start[MAX_GROUP_CELLS + 1][MAX_GROUP_CELLS + 2];
+  int ways[MAX_GROUP_CELLS + 1][MAX_GROUP_CELLS + 1][MAX_GROUP_CELLS + 1];
+
+  constexpr GroupFillings() : masks(), start(), ways() {
+    int bits[1 << MAX_GROUP_CELLS] = {};
+    for (int m = 1; m < (1 << MAX_GROUP_CELLS); ++m)
+      bits[m] = bits[m >> 1] + (m & 1);
+
+    int pos = 0;
+    for (int n = 0; n <= MAX_GROUP_CELLS; ++n) {
+      for (int k = 0; k <= n + 1; ++k) {
+        start[n][k] = pos;
+        for (int m = 0; m < (1 << n) && k <= n; ++m) {
+          if (bits[m] == k)
+            masks[pos++] = (uint8_t) m;
+        }
+      }
+
+      for (int lo = 0; lo <= MAX_GROUP_CELLS; ++lo) {
+        for (int hi = 0; hi <= MAX_GROUP_CELLS; ++hi) {
+          int k1 = lo <= n ? lo : n + 1;
+          int k2 = hi < n ? hi + 1 : n + 1;
+          ways[n][lo][hi] = k1 < k2 ? start[n][k2] - start[n][k1] : 0;
+        }
+      }
+    }
   }
+};
+static constexpr GroupFillings fillings;
+
+// Tries every filling of the C unassigned cells of a group with mn to mx mines and
+// recurses into the consistent ones. C is a template parameter so that the walk
+// over the mask table and the loops over the cells are unrolled for each group size.
+template <int C>
+void Solver::fillGroup(ChainSearch& s, const int* to_assign, int mn, int mx) const {
+  for (int v = mn; v <= mx; ++v) {
+    for (int m = fillings.start[C][v]; m < fillings.start[C][v + 1]; ++m) {
+      uint32_t mask = fillings.masks[m];
+      // A group that cannot be satisfied stays so as more cells get assigned
+      bool valid = true;
+      for (int i = 0; i < C; ++i) {
+        int x = (mask >> i) & 1;
+        uint64_t bit = 1ULL << (to_assign[i] & 63);
+        if (x)
+          s.mines[to_assign[i] >> 6] |= bit;
+        else
+          s.mines[to_assign[i] >> 6] &= ~bit;
+        for (int g : s.cellGroups[to_assign[i]]) {
+          SearchGroup& sg = s.groups[g];
+          sg.placed += x;
+          sg.open -= 1;
+          s.openGroups -= sg.open == 0;
+          valid &= sg.placed <= sg.maxV && sg.placed + sg.open >= sg.minV;
+        }
+      }
 
-  Group* g = chain[order[id]];
-  const vector<int>& cells_id = group_cells_id[order[id]];
+      if (valid) {
+        s.nMines += v;
+        solveRec(s);
+        s.nMines -= v;
+      } else {
+        s.counters.pruned += 1;
+      }
 
-  vector<int> to_assign;
-  int c = (int) cells_id.size();
-  int mx = g->maxV;
-  int mn = g->minV;
-  for (int idx : cells_id) {
-    if (sol[idx] == -1) {
-      to_assign.push_back(idx);
-      continue;
+      for (int i = 0; i < C; ++i) {
+        int x = (mask >> i) & 1;
+        for (int g : s.cellGroups[to_assign[i]]) {
+          SearchGroup& sg = s.groups[g];
+          s.openGroups += sg.open == 0;
+          sg.placed -= x;
+          sg.open += 1;
+        }
+      }
     }
-    c -= 1;
-    mx -= sol[idx];
-    mn -= sol[idx];
   }
+}
 
-  if (mx < 0)
+// Recursively enumerates all valid mine assignments for a chain of groups. Every
+// node fills the unassigned cells of the open group with the fewest ways left to
+// fill it (then the fewest unassigned cells), so that forced groups go first and
+// the search follows the constraints that earlier assignments tightened. Mines
+// placed and cells left are kept per group and updated for every group containing
+// an assigned cell, which prunes an assignment as soon as any group can no longer
+// be satisfied. Accumulates configuration counts and per-cell mine frequencies
+// indexed by total mine count, and stores every configuration in all_configs
+// unless it is null.
+// The partial solution is kept as two bitsets over the chain's cells (assigned and
+// mine), and the unassigned cells of a group are filled by fillGroup() from the
+// compile-time mask tables, so search nodes do not allocate.
+void Solver::solveRec(ChainSearch& s) const {
+  SearchCounters& counters = s.counters;
+  counters.nodes += 1;
+  if (s.budget && counters.nodes % BUDGET_POLL_INTERVAL == 0 && s.budget->charge(BUDGET_POLL_INTERVAL))
+    counters.stopped = true;
+  if (counters.stopped)
     return;
-  if (mn > c)
-    return;
-  mn = max(mn, 0);
-  for (int v = mn; v <= mx; ++v) {
-    const vector<vector<int>>& tries = getCombinations(c, v);
-    for (const vector<int>& a_try : tries) {
-      int i = 0;
-      for (int j : to_assign)
-        sol[j] = a_try[i++];
-      solveRec(chain, order, group_cells_id, freq_no_mines, freq_mines_pos, sol, all_configs, id+1);
+
+  if (s.openGroups == 0) {
+    for (int wi = 0; wi < (int) s.mines.size(); ++wi) {
+      for (uint64_t w = s.mines[wi]; w != 0; w &= w - 1)
+        s.freq_mines_pos[s.nMines][wi * 64 + lowestBit64(w)] += 1;
     }
+    if (s.all_configs)
+      s.all_configs->add(s.mines.data());
+    s.freq_no_mines[s.nMines] += 1;
+    return;
   }
 
-  for (int idx : to_assign)
-    sol[idx] = -1;
-}
-
-// Solves a single chain by determining an optimal group processing order (most
-// overlapping groups first for better pruning), mapping cells to indices, and
-// running the recursive enumerator. Returns per-cell mine frequencies grouped
-// by total mine count, along with all valid configurations.
-Solver::ChainSolution Solver::solveChain(const vector<Group*>& chain) const {
-  vector<vector<Group*>> overlaps;
-  int n = (int) chain.size();
-  int mx = -1;
-  int mv = -1;
-  int mId = -1;
-  for (int i = 0; i < n; ++i) {
-    overlaps.push_back(chain[i]->getOverlaps());
-    int l = (int)overlaps.back().size();
-    if (mv < l) {
-      mv = l;
-      mx = i;
+  int best = -1;
+  int bestWays = 0;
+  for (int g = 0; g < (int) s.groups.size(); ++g) {
+    const SearchGroup& sg = s.groups[g];
+    if (sg.open == 0)
+      continue;
+    int ways = fillings.ways[sg.open][max(sg.minV - sg.placed, 0)][min(sg.maxV - sg.placed, sg.open)];
+    if (best == -1 || ways < bestWays || (ways == bestWays && sg.open < s.groups[best].open)) {
+      best = g;
+      bestWays = ways;
+      if (ways == 1)
+        break;
     }
-    mId = max(mId, chain[i]->id);
   }
 
-  vector<int> gid2i(mId + 1);
-  vector<int> id(n);
-  for (int i = 0; i < n; ++i) {
-    gid2i[chain[i]->id] = i;
-    id[i] = i;
-  }
+  const vector<int>& cells_id = (*s.group_cells_id)[best];
+  assert((int) cells_id.size() <= MAX_GROUP_CELLS);
 
-  for (int i = 0; i < n; ++i) {
-    sort(overlaps[i].begin(), overlaps[i].end(), [&overlaps, &gid2i](Group* g1, Group* g2) {
-      return overlaps[gid2i[g1->id]].size() > overlaps[gid2i[g2->id]].size();
-    });
+  int to_assign[MAX_GROUP_CELLS];
+  int c = 0;
+  for (int idx : cells_id) {
+    if (!(s.assigned[idx >> 6] & (1ULL << (idx & 63))))
+      to_assign[c++] = idx;
   }
-  sort(id.begin(), id.end(), [&overlaps](int a, int b) {
-    return overlaps[a].size() > overlaps[b].size();
-  });
-
-  vector<bool> existed(mId+1, false);
-  vector<int> processQ;
-  existed[mx] = true;
-  processQ.push_back(mx);
-  for (int i = 0; i < n; ++i) {
-    for (Group* g : overlaps[id[i]]) {
-      int idx = gid2i[g->id];
-      if (existed[idx])
-        continue;
-      existed[idx] = true;
-      processQ.push_back(idx);
-    }
+  int mn = max(s.groups[best].minV - s.groups[best].placed, 0);
+  int mx = min(s.groups[best].maxV - s.groups[best].placed, c);
+
+  for (int i = 0; i < c; ++i)
+    s.assigned[to_assign[i] >> 6] |= 1ULL << (to_assign[i] & 63);
+
+  switch (c) {
+  case 1: fillGroup<1>(s, to_assign, mn, mx); break;
+  case 2: fillGroup<2>(s, to_assign, mn, mx); break;
+  case 3: fillGroup<3>(s, to_assign, mn, mx); break;
+  case 4: fillGroup<4>(s, to_assign, mn, mx); break;
+  case 5: fillGroup<5>(s, to_assign, mn, mx); break;
+  case 6: fillGroup<6>(s, to_assign, mn, mx); break;
+  case 7: fillGroup<7>(s, to_assign, mn, mx); break;
+  case 8: fillGroup<8>(s, to_assign, mn, mx); break;
   }
 
-  set<Cell*> relatedCells;
-  for (Group* g : chain) {
-    for (Cell* c: g->groupcells)
-      relatedCells.insert(c);
+  for (int i = 0; i < c; ++i) {
+    uint64_t bit = 1ULL << (to_assign[i] & 63);
+    s.assigned[to_assign[i] >> 6] &= ~bit;
+    s.mines[to_assign[i] >> 6] &= ~bit;
   }
+}
+
+// Collects the cells of a chain and maps every group to the indices of its cells,
+// numbering cells in relatedCells iteration order.
+void Solver::indexChainCells(const vector<Group*>& chain, CellSet& relatedCells,
+                             vector<vector<int>>& group_cells_id) {
+  relatedCells = CellSet();
+  for (Group* g : chain)
+    relatedCells.unite(g->groupcells);
 
-  int nCells = (int) relatedCells.size();
   unordered_map<Cell*, int> c2i;
   int idx = 0;
   for (Cell* c : relatedCells)
     c2i[c] = idx++;
 
-  vector<int> freq_no_mines(nCells, 0);
-  vector<vector<int>> freq_mines_pos(nCells, vector<int>(nCells, 0));
-  vector<vector<int>> groups_cell_id(chain.size());
-  for (int i = 0; i < n; ++i) {
+  group_cells_id.assign(chain.size(), vector<int>());
+  for (int i = 0; i < (int) chain.size(); ++i) {
     for (Cell* c : chain[i]->groupcells)
-      groups_cell_id[i].push_back(c2i.find(c)->second);
+      group_cells_id[i].push_back(c2i.find(c)->second);
   }
+}
 
-  vector<int> sol(nCells, -1);
-  vector<vector<int>> all_configs;
-  solveRec(chain, processQ, groups_cell_id, freq_no_mines, freq_mines_pos, sol, all_configs);
+// Solves a single chain by mapping cells to indices and running the recursive
+// enumerator, which picks its group order as it goes. Returns per-cell mine
+// frequencies grouped by total mine count, along with all valid configurations if
+// keepConfigs is set.
+Solver::ChainSolution Solver::solveChain(const vector<Group*>& chain, bool keepConfigs, SolveBudget* budget) const {
+  TRACE_SCOPE("solveChain");
+  CellSet relatedCells;
+  vector<vector<int>> groups_cell_id;
+  indexChainCells(chain, relatedCells, groups_cell_id);
 
+  int nCells = (int) relatedCells.size();
+  int nGroups = (int) chain.size();
+  ConfigSet all_configs(nCells);
+  ChainSearch search;
+  search.group_cells_id = &groups_cell_id;
+  search.cellGroups.assign(nCells, vector<int>());
+  for (int g = 0; g < nGroups; ++g) {
+    for (int c : groups_cell_id[g])
+      search.cellGroups[c].push_back(g);
+    search.groups.push_back({ 0, (int) groups_cell_id[g].size(), chain[g]->minV, chain[g]->maxV });
+  }
+  search.assigned.assign((nCells + 63) / 64, 0);
+  search.mines.assign((nCells + 63) / 64, 0);
+  search.openGroups = nGroups;
+  search.nMines = 0;
+  search.freq_no_mines.assign(nCells + 1, 0);
+  search.freq_mines_pos.assign(nCells + 1, vector<double>(nCells, 0));
+  search.all_configs = keepConfigs ? &all_configs : nullptr;
+  search.budget = budget;
+  solveRec(search);
+
+  const vector<double>& freq_no_mines = search.freq_no_mines;
+  const vector<vector<double>>& freq_mines_pos = search.freq_mines_pos;
   vector<int> no_mines;
-  vector<int> freq_no_mines_out;
-  vector<vector<int>> freq_mines_pos_out;
-  for (int i = 0; i < nCells; ++i) {
+  vector<double> freq_no_mines_out;
+  vector<vector<double>> freq_mines_pos_out;
+  for (int i = 0; i <= nCells; ++i) {
     if (freq_no_mines[i] == 0)
       continue;
     no_mines.push_back(i);
@@ -662,214 +1042,1178 @@ Solver::ChainSolution Solver::solveChain(const vector<Group*>& chain) const {
     no_mines, 
     freq_no_mines_out,
     freq_mines_pos_out,
-    all_configs
+    0,
+    std::move(all_configs),
+    search.counters,
+    false,
+    vector<float>()
   };
 }
 
-// Updates groups to account for newly solved cells: disables groups fully covered
-// by solved cells and creates reduced sub-groups for partially covered ones, adjusting
-// mine counts based on whether solved cells were mines or safe. Returns false on contradiction.
-bool Solver::filter() {
-  int maxId = (int) groups.size();
-  for (int i = 0; i < maxId; ++i) {
-    Group* g = groups[i];
+// Orders the cells of a chain for the frontier sweep: breadth-first over cells that
+// share a group, starting from a cell found last by a first breadth-first pass, so
+// that the cells of a group end up close together and few cells stay open at once.
+static vector<int> frontierOrder(int nCells, const vector<vector<int>>& group_cells_id) {
+  vector<vector<int>> cellGroups(nCells);
+  for (int g = 0; g < (int) group_cells_id.size(); ++g) {
+    for (int c : group_cells_id[g])
+      cellGroups[c].push_back(g);
+  }
 
-    if (g->disabled)
+  vector<int> order;
+  int start = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    order.clear();
+    vector<bool> visited(nCells, false);
+    for (int root = start, k = 0; k < nCells; root = k++) {
+      if (visited[root])
+        continue;
+      queue<int> process;
+      process.push(root);
+      visited[root] = true;
+      while (!process.empty()) {
+        int c = process.front();
+        process.pop();
+        order.push_back(c);
+        for (int g : cellGroups[c]) {
+          for (int c2 : group_cells_id[g]) {
+            if (visited[c2])
+              continue;
+            visited[c2] = true;
+            process.push(c2);
+          }
+        }
+      }
+    }
+    start = order.back();
+  }
+  return order;
+}
+
+// normalizeCounts() over every count of a frontier layer.
+static int normalizeLayer(unordered_map<uint64_t, vector<double>>& layer) {
+  double top = 0;
+  for (auto& [state, counts] : layer) {
+    for (double v : counts)
+      top = max(top, v);
+  }
+  if (top == 0)
+    return 0;
+  int exponent;
+  std::frexp(top, &exponent);
+  for (auto& [state, counts] : layer) {
+    for (double& v : counts)
+      v = std::ldexp(v, -exponent);
+  }
+  return exponent;
+}
+
+// Counts the configurations of a chain without enumerating them, by sweeping its
+// cells in frontierOrder and keeping, for every assignment of the open cells (swept
+// cells that still belong to a group with unswept cells), the number of ways to
+// reach it by mine count. A backward pass over the same states gives the per-cell
+// frequencies. Produces the same counts as solveChain but leaves all_configs empty.
+// Returns false without solving if more than maxWidth cells would be open at once.
+bool Solver::solveChainFrontier(const vector<Group*>& chain, ChainSolution& out, int maxWidth,
+                                SolveBudget* budget) const {
+  TRACE_SCOPE("solveChainFrontier");
+  CellSet relatedCells;
+  vector<vector<int>> group_cells_id;
+  indexChainCells(chain, relatedCells, group_cells_id);
+
+  int nCells = (int) relatedCells.size();
+  int nGroups = (int) chain.size();
+  vector<int> order = frontierOrder(nCells, group_cells_id);
+  vector<int> pos(nCells);
+  for (int t = 0; t < nCells; ++t)
+    pos[order[t]] = t;
+
+  // A cell stays open until the last group containing it is closed
+  vector<int> closeAt(nGroups, -1);
+  vector<int> lastUse(nCells, -1);
+  for (int g = 0; g < nGroups; ++g) {
+    for (int c : group_cells_id[g])
+      closeAt[g] = max(closeAt[g], pos[c]);
+    for (int c : group_cells_id[g])
+      lastUse[c] = max(lastUse[c], closeAt[g]);
+  }
+
+  // open[t]: cells open before step t, in sweep order
+  vector<vector<int>> open(nCells + 1);
+  for (int t = 0; t < nCells; ++t) {
+    for (int c : open[t]) {
+      if (lastUse[c] > t)
+        open[t + 1].push_back(c);
+    }
+    if (lastUse[order[t]] > t)
+      open[t + 1].push_back(order[t]);
+    if ((int) open[t].size() + 1 > maxWidth)
+      return false;
+  }
+
+  // Step t extends a state over open[t] with cell order[t] as its top bit, checks the
+  // groups containing that cell and projects the result onto open[t + 1].
+  struct GroupCheck {
+    uint64_t mask;
+    int remaining;
+    int minV;
+    int maxV;
+  };
+  vector<vector<GroupCheck>> checks(nCells);
+  vector<vector<int>> source(nCells);
+  for (int t = 0; t < nCells; ++t) {
+    unordered_map<int, int> slot;
+    for (int j = 0; j < (int) open[t].size(); ++j)
+      slot[open[t][j]] = j;
+    slot[order[t]] = (int) open[t].size();
+
+    for (int c : open[t + 1])
+      source[t].push_back(slot[c]);
+
+    for (int g = 0; g < nGroups; ++g) {
+      GroupCheck check = { 0, 0, chain[g]->minV, chain[g]->maxV };
+      bool contains = false;
+      for (int c : group_cells_id[g]) {
+        contains |= c == order[t];
+        if (pos[c] <= t)
+          check.mask |= 1ULL << slot[c];
+        else
+          check.remaining += 1;
+      }
+      if (contains)
+        checks[t].push_back(check);
+    }
+  }
+
+  auto extend = [&](int t, uint64_t state, int x, uint64_t& next) {
+    uint64_t ext = state | ((uint64_t) x << open[t].size());
+    for (const GroupCheck& check : checks[t]) {
+      int placed = popcount64(ext & check.mask);
+      if (placed > check.maxV || placed + check.remaining < check.minV)
+        return false;
+    }
+    next = 0;
+    for (int j = 0; j < (int) source[t].size(); ++j)
+      next |= ((ext >> source[t][j]) & 1) << j;
+    return true;
+  };
+
+  // forward[t][state][m]: assignments of the first t cells ending in state with m mines,
+  // times 2^-forwardScale[t]. Every layer is renormalized so that long chains do
+  // not overflow.
+  vector<unordered_map<uint64_t, vector<double>>> forward(nCells + 1);
+  vector<int> forwardScale(nCells + 1, 0);
+  SearchCounters counters;
+  forward[0][0] = vector<double>(1, 1);
+  for (int t = 0; t < nCells && !counters.stopped; ++t) {
+    if (budget && budget->charge(forward[t].size()))
+      counters.stopped = true;
+    for (auto& [state, counts] : forward[t]) {
+      counters.nodes += 1;
+      for (int x = 0; x <= 1; ++x) {
+        uint64_t next;
+        if (!extend(t, state, x, next)) {
+          counters.pruned += 1;
+          continue;
+        }
+        vector<double>& dst = forward[t + 1][next];
+        if (dst.empty())
+          dst.assign(t + 2, 0);
+        for (int m = 0; m <= t; ++m)
+          dst[m + x] += counts[m];
+      }
+    }
+    forwardScale[t + 1] = forwardScale[t] + normalizeLayer(forward[t + 1]);
+  }
+
+  if (counters.stopped) {
+    out.search = counters;
+    return true;
+  }
+
+  vector<double> freq_no_mines(nCells + 1, 0);
+  vector<vector<double>> freq_mines_pos(nCells + 1, vector<double>(nCells, 0));
+  auto complete = forward[nCells].find(0);
+  if (complete != forward[nCells].end())
+    freq_no_mines = complete->second;
+
+  // backward[state][m]: completions of the cells after step t from state with m
+  // mines, times 2^-backwardScale
+  unordered_map<uint64_t, vector<double>> backward;
+  int backwardScale = 0;
+  backward[0] = vector<double>(1, 1);
+  for (int t = nCells - 1; t >= 0; --t) {
+    unordered_map<uint64_t, vector<double>> previous;
+    vector<double> withMine(nCells + 1, 0);
+    for (auto& [state, counts] : forward[t]) {
+      for (int x = 0; x <= 1; ++x) {
+        uint64_t next;
+        if (!extend(t, state, x, next))
+          continue;
+        auto it = backward.find(next);
+        if (it == backward.end())
+          continue;
+        const vector<double>& rest = it->second;
+        vector<double>& dst = previous[state];
+        if (dst.empty())
+          dst.assign(nCells - t + 1, 0);
+        for (int m = 0; m < (int) rest.size(); ++m)
+          dst[m + x] += rest[m];
+
+        if (x == 0)
+          continue;
+        for (int a = 0; a < (int) counts.size(); ++a) {
+          if (counts[a] == 0)
+            continue;
+          for (int b = 0; b < (int) rest.size(); ++b)
+            withMine[a + 1 + b] += counts[a] * rest[b];
+        }
+      }
+    }
+    for (int k = 0; k <= nCells; ++k)
+      freq_mines_pos[k][order[t]] = std::ldexp(withMine[k], forwardScale[t] + backwardScale - forwardScale[nCells]);
+    backwardScale += normalizeLayer(previous);
+    backward.swap(previous);
+  }
+
+  out.relatedCells = relatedCells;
+  out.no_mines.clear();
+  out.freq_no_mines.clear();
+  out.freq_mines_pos.clear();
+  out.scale = forwardScale[nCells];
+  out.all_configs = ConfigSet(nCells);
+  out.search = counters;
+  for (int i = 0; i <= nCells; ++i) {
+    if (freq_no_mines[i] == 0)
       continue;
-    set<Cell*> intersect = g->intersect(solvedCells);
-    if (intersect.size() == 0)
+    out.no_mines.push_back(i);
+    out.freq_no_mines.push_back(freq_no_mines[i]);
+    out.freq_mines_pos.push_back(freq_mines_pos[i]);
+  }
+  return true;
+}
+
+// A mine-count polynomial: c[k] configurations with lo + k mines, times 2^scale.
+struct MinePoly {
+  int lo = 0;
+  vector<double> c = { 1.0 };
+  int scale = 0;
+};
+
+static MinePoly multiplyMinePolys(const MinePoly& a, const MinePoly& b) {
+  MinePoly out;
+  out.lo = a.lo + b.lo;
+  out.c = convolveMineCounts(a.c, b.c);
+  out.scale = a.scale + b.scale + normalizeCounts(out.c);
+  return out;
+}
+
+// Picks the cut for solveChainSplit: a breadth-first layer of cells (cells sharing a
+// group are adjacent), counted from a cell found last by a first breadth-first pass.
+// Cells sharing a group are at most one layer apart, so a layer separates the cells
+// before it from the cells after it. Only the middle half of the layers is
+// considered, and the smallest layer of at most SPLIT_MAX_CUT cells is taken, the
+// most central one on ties. Returns the cut's cells, or nothing if no layer fits.
+static vector<int> findChainCut(int nCells, const vector<vector<int>>& group_cells_id) {
+  vector<vector<int>> cellGroups(nCells);
+  for (int g = 0; g < (int) group_cells_id.size(); ++g) {
+    for (int c : group_cells_id[g])
+      cellGroups[c].push_back(g);
+  }
+
+  vector<int> dist;
+  int start = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    dist.assign(nCells, -1);
+    queue<int> process;
+    process.push(start);
+    dist[start] = 0;
+    while (!process.empty()) {
+      int c = process.front();
+      process.pop();
+      start = c;
+      for (int g : cellGroups[c]) {
+        for (int c2 : group_cells_id[g]) {
+          if (dist[c2] >= 0)
+            continue;
+          dist[c2] = dist[c] + 1;
+          process.push(c2);
+        }
+      }
+    }
+  }
+
+  int depth = 0;
+  for (int d : dist)
+    depth = max(depth, d);
+  vector<int> layerSize(depth + 1, 0);
+  for (int d : dist) {
+    if (d >= 0)
+      layerSize[d] += 1;
+  }
+
+  int best = -1;
+  for (int d = max(1, depth / 4); d <= min(depth - 1, 3 * depth / 4); ++d) {
+    if (layerSize[d] > SPLIT_MAX_CUT)
       continue;
+    if (best < 0 || layerSize[d] < layerSize[best] ||
+        (layerSize[d] == layerSize[best] && abs(2 * d - depth) < abs(2 * best - depth)))
+      best = d;
+  }
 
-    g->disabled = true;
-    if (intersect.size() == g->groupcells.size())
+  vector<int> cut;
+  for (int c = 0; best >= 0 && c < nCells; ++c) {
+    if (dist[c] == best)
+      cut.push_back(c);
+  }
+  return cut;
+}
+
+// Counts a chain by cutset conditioning: findChainCut picks a few cells whose removal
+// splits the chain, and for every assignment of those cells the remaining groups,
+// with their bounds reduced by the mines placed in the cut, fall apart into
+// independent sub-chains. Every sub-chain is counted exactly (swept or enumerated)
+// and counted once per distinct set of bounds; the product of their
+// mine-count polynomials, shifted by the mines in the cut, is summed over the
+// assignments. Work is exponential in the cut width rather than in the chain length.
+// Returns false if there is no small cut, or if a sub-chain of FRONTIER_MIN_CELLS
+// cells or more cannot be swept. Sub-chains are not split again, as the
+// assignments of nested cuts would multiply.
+bool Solver::solveChainSplit(const vector<Group*>& chain, ChainSolution& out, SolveBudget* budget) const {
+  TRACE_SCOPE("solveChainSplit");
+  CellSet relatedCells;
+  vector<vector<int>> group_cells_id;
+  indexChainCells(chain, relatedCells, group_cells_id);
+  int nCells = (int) relatedCells.size();
+  int nGroups = (int) chain.size();
+
+  vector<int> cut = findChainCut(nCells, group_cells_id);
+  if (cut.empty())
+    return false;
+  int nCut = (int) cut.size();
+  vector<int> cutIndex(nCells, -1);
+  for (int k = 0; k < nCut; ++k)
+    cutIndex[cut[k]] = k;
+
+  // Pieces: connected sets of the cells left once the cut is removed
+  vector<int> parent(nCells);
+  for (int c = 0; c < nCells; ++c)
+    parent[c] = c;
+  auto root = [&](int c) {
+    while (parent[c] != c)
+      c = parent[c] = parent[parent[c]];
+    return c;
+  };
+  vector<uint32_t> cutMask(nGroups, 0);
+  for (int g = 0; g < nGroups; ++g) {
+    int first = -1;
+    for (int c : group_cells_id[g]) {
+      if (cutIndex[c] >= 0) {
+        cutMask[g] |= 1u << cutIndex[c];
+        continue;
+      }
+      if (first < 0)
+        first = root(c);
+      else
+        parent[root(c)] = first;
+    }
+  }
+
+  vector<int> piece(nCells, -1);
+  vector<vector<int>> pieceCells; // ascending, so in the order a sub-chain indexes them
+  for (int c = 0; c < nCells; ++c) {
+    if (cutIndex[c] >= 0)
       continue;
+    int r = root(c);
+    if (piece[r] < 0) {
+      piece[r] = (int) pieceCells.size();
+      pieceCells.push_back(vector<int>());
+    }
+    piece[c] = piece[r];
+    pieceCells[piece[c]].push_back(c);
+  }
+  int nPieces = (int) pieceCells.size();
+
+  // The groups of every piece, without their cut cells; their bounds are set for
+  // every assignment of the cut
+  vector<Cell*> cells(relatedCells.begin(), relatedCells.end());
+  vector<vector<Group>> pieceGroups(nPieces);
+  vector<int> groupPiece(nGroups, -1);
+  for (int g = 0; g < nGroups; ++g) {
+    for (int c : group_cells_id[g]) {
+      if (cutIndex[c] < 0) {
+        groupPiece[g] = piece[c];
+        break;
+      }
+    }
+    if (groupPiece[g] < 0)
+      continue;
+    Group reduced;
+    reduced.groupcells = CellSet(relatedCells.board);
+    for (int c : group_cells_id[g]) {
+      if (cutIndex[c] < 0)
+        reduced.groupcells.insert(cells[c]);
+    }
+    pieceGroups[groupPiece[g]].push_back(reduced);
+  }
+  vector<vector<Group*>> subChains(nPieces);
+  for (int p = 0; p < nPieces; ++p) {
+    for (Group& g : pieceGroups[p])
+      subChains[p].push_back(&g);
+  }
 
-    Group* newG = new Group(g->subtract(solvedCells));
-    newG->minV = g->minV;
-    newG->maxV = g->maxV;
-    for (Cell* c : intersect) {
-      if (c->minePerc == 100.f) {
-        newG->minV -= 1;
-        newG->maxV -= 1;
-        
-        if (newG->maxV < 0)
-          return false;
+  vector<map<vector<int>, ChainSolution>> solved(nPieces);
+  vector<double> total(nCells + 1, 0);
+  vector<vector<double>> withMine(nCells + 1, vector<double>(nCells, 0));
+  int scale = 0;
+  bool any = false;
+  SearchCounters counters;
 
-        if (newG->minV < 0)
-          newG->minV = 0;
+  for (uint32_t assign = 0; assign < (1u << nCut); ++assign) {
+    if (budget && budget->exhausted()) {
+      counters.stopped = true;
+      break;
+    }
+
+    // Bounds of every piece's groups under this assignment
+    bool valid = true;
+    vector<vector<int>> bounds(nPieces);
+    for (int g = 0; g < nGroups && valid; ++g) {
+      int placed = popcount64(assign & cutMask[g]);
+      int rest = (int) group_cells_id[g].size() - popcount64(cutMask[g]);
+      int minV = max(chain[g]->minV - placed, 0);
+      int maxV = min(chain[g]->maxV - placed, rest);
+      valid = minV <= maxV;
+      if (groupPiece[g] >= 0) {
+        bounds[groupPiece[g]].push_back(minV);
+        bounds[groupPiece[g]].push_back(maxV);
       }
     }
+    if (!valid)
+      continue;
 
-    addGroup(newG);
+    vector<const ChainSolution*> subs(nPieces);
+    for (int p = 0; p < nPieces && valid; ++p) {
+      auto it = solved[p].find(bounds[p]);
+      if (it == solved[p].end()) {
+        for (int k = 0; k < (int) pieceGroups[p].size(); ++k) {
+          pieceGroups[p][k].minV = bounds[p][2 * k];
+          pieceGroups[p][k].maxV = bounds[p][2 * k + 1];
+        }
+        ChainSolution sub;
+        int n = (int) pieceCells[p].size();
+        if (!(n >= FRONTIER_MIN_CELLS && solveChainFrontier(subChains[p], sub, FRONTIER_MAX_WIDTH, budget))) {
+          if (n >= FRONTIER_MIN_CELLS)
+            return false;
+          sub = solveChain(subChains[p], false, budget);
+        }
+        counters.nodes += sub.search.nodes;
+        counters.pruned += sub.search.pruned;
+        counters.stopped |= sub.search.stopped;
+        it = solved[p].emplace(bounds[p], std::move(sub)).first;
+      }
+      subs[p] = &it->second;
+      valid = !subs[p]->no_mines.empty();
+    }
+    if (counters.stopped)
+      break;
+    if (!valid)
+      continue;
+
+    vector<MinePoly> polys(nPieces);
+    for (int p = 0; p < nPieces; ++p) {
+      const ChainSolution& s = *subs[p];
+      polys[p].lo = s.no_mines.front();
+      polys[p].c.assign(s.no_mines.back() - s.no_mines.front() + 1, 0);
+      for (int j = 0; j < (int) s.no_mines.size(); ++j)
+        polys[p].c[s.no_mines[j] - polys[p].lo] = s.freq_no_mines[j];
+      polys[p].scale = s.scale;
+    }
+    vector<MinePoly> prefix(nPieces + 1), suffix(nPieces + 1);
+    for (int p = 0; p < nPieces; ++p)
+      prefix[p + 1] = multiplyMinePolys(prefix[p], polys[p]);
+    for (int p = nPieces - 1; p >= 0; --p)
+      suffix[p] = multiplyMinePolys(polys[p], suffix[p + 1]);
+
+    // Bring the sums to this assignment's scale if it is the larger one
+    const MinePoly& all = prefix[nPieces];
+    int shift = all.lo + popcount64(assign);
+    if (!any || all.scale > scale) {
+      double factor = any ? std::ldexp(1.0, scale - all.scale) : 0;
+      for (int k = 0; k <= nCells; ++k) {
+        total[k] *= factor;
+        for (double& v : withMine[k])
+          v *= factor;
+      }
+      scale = all.scale;
+      any = true;
+    }
+
+    double factor = std::ldexp(1.0, all.scale - scale);
+    for (int k = 0; k < (int) all.c.size(); ++k) {
+      total[shift + k] += all.c[k] * factor;
+      for (int i = 0; i < nCut; ++i) {
+        if ((assign >> i) & 1)
+          withMine[shift + k][cut[i]] += all.c[k] * factor;
+      }
+    }
+
+    for (int p = 0; p < nPieces; ++p) {
+      const ChainSolution& s = *subs[p];
+      MinePoly others = multiplyMinePolys(prefix[p], suffix[p + 1]);
+      double f = std::ldexp(1.0, s.scale + others.scale - scale);
+      for (int j = 0; j < (int) s.no_mines.size(); ++j) {
+        int base = s.no_mines[j] + others.lo + popcount64(assign);
+        for (int l = 0; l < (int) pieceCells[p].size(); ++l) {
+          double mine = s.freq_mines_pos[j][l] * f;
+          if (mine == 0)
+            continue;
+          for (int k = 0; k < (int) others.c.size(); ++k)
+            withMine[base + k][pieceCells[p][l]] += mine * others.c[k];
+        }
+      }
+    }
   }
 
-  filterTrivial();
+  out.relatedCells = relatedCells;
+  out.no_mines.clear();
+  out.freq_no_mines.clear();
+  out.freq_mines_pos.clear();
+  out.scale = scale;
+  out.all_configs = ConfigSet(nCells);
+  out.search = counters;
+  for (int k = 0; k <= nCells; ++k) {
+    if (total[k] == 0)
+      continue;
+    out.no_mines.push_back(k);
+    out.freq_no_mines.push_back(total[k]);
+    out.freq_mines_pos.push_back(withMine[k]);
+  }
   return true;
 }
 
-void Solver::sampleConfiguration(const Solver& solver, int mines,
-                                 vector<vector<int>>& mineConf, std::mt19937& rng) {
-  int h = solver.board.height;
-  int w = solver.board.width;
-  mineConf.assign(h, vector<int>(w, -1));
+// Estimates the counts of a chain too large to count exactly, by sequential Monte
+// Carlo: a pass moves APPROX_PARTICLES partial assignments through the cells in
+// frontierOrder. Every particle picks uniformly among the values that keep the
+// groups containing the cell satisfiable and doubles its weight when both were
+// possible; particles that hit a dead end are dropped, and whenever the weights get
+// too uneven the particles are resampled in proportion to them. The final weights
+// give unbiased counts by mine count. Passes are repeated until APPROX_MAX_SAMPLES
+// particles or approxTimeMs milliseconds (at least two passes, unless the budget
+// runs out), and the spread of the passes' estimates gives out.error.
+void Solver::solveChainApprox(const vector<Group*>& chain, ChainSolution& out, SolveBudget* budget) const {
+  TRACE_SCOPE("solveChainApprox");
+  CellSet relatedCells;
+  vector<vector<int>> group_cells_id;
+  indexChainCells(chain, relatedCells, group_cells_id);
 
-  // Fill deterministic cells
-  int adjustedMines = mines;
-  for (int r = 0; r < h; ++r) {
-    for (int c = 0; c < w; ++c) {
-      const Cell* cell = solver.board.getCell(r, c);
-      if (cell->value >= 0) {
-        mineConf[r][c] = 0;
-      } else if (cell->minePerc == 0.f) {
-        mineConf[r][c] = 0;
-      } else if (cell->minePerc == 100.f) {
-        mineConf[r][c] = 1;
-        adjustedMines -= 1;
+  int nCells = (int) relatedCells.size();
+  int nGroups = (int) chain.size();
+  vector<int> order = frontierOrder(nCells, group_cells_id);
+  vector<int> pos(nCells);
+  for (int t = 0; t < nCells; ++t)
+    pos[order[t]] = t;
+
+  // checks[t]: bounds on the mines among cells assigned before step t plus cell
+  // order[t], from the groups containing that cell. Groups over the same assigned
+  // cells share one check, and checks that always hold are left out.
+  struct GroupCheck {
+    vector<int> assigned;
+    int lo;
+    int hi;
+  };
+  vector<vector<GroupCheck>> checks(nCells);
+  vector<map<vector<int>, int>> checkIndex(nCells);
+  uint64_t seed = chain[0]->serial;
+  for (int g = 0; g < nGroups; ++g) {
+    seed = min(seed, chain[g]->serial);
+    for (int c : group_cells_id[g]) {
+      vector<int> assigned;
+      int remaining = 0;
+      for (int c2 : group_cells_id[g]) {
+        if (pos[c2] < pos[c])
+          assigned.push_back(c2);
+        else if (pos[c2] > pos[c])
+          remaining += 1;
+      }
+      sort(assigned.begin(), assigned.end());
+      int lo = chain[g]->minV - remaining, hi = chain[g]->maxV;
+      auto [it, added] = checkIndex[pos[c]].emplace(assigned, (int) checks[pos[c]].size());
+      if (added) {
+        checks[pos[c]].push_back({ assigned, lo, hi });
+      } else {
+        GroupCheck& check = checks[pos[c]][it->second];
+        check.lo = max(check.lo, lo);
+        check.hi = min(check.hi, hi);
       }
     }
   }
+  for (vector<GroupCheck>& step : checks) {
+    step.erase(remove_if(step.begin(), step.end(), [](const GroupCheck& check) {
+      return check.lo <= 0 && check.hi >= (int) check.assigned.size() + 1;
+    }), step.end());
+  }
 
-  // Recompute chain data
-  vector<vector<Group*>> chains = solver.getGroupChains();
-  vector<Solver::ChainSolution> chain_sols;
-  for (const vector<Group*>& g : chains)
-    chain_sols.push_back(solver.solveChain(g));
+  // Weights are kept as log2; the sums over passes are relative to 2^top and
+  // rescaled when a larger pass estimate comes up.
+  double top = -std::numeric_limits<double>::infinity();
+  vector<double> W(nCells + 1, 0);                                  // count by mine count
+  vector<vector<double>> WX(nCells + 1, vector<double>(nCells, 0)); // count by mine count and mine cell
+  double Z = 0, Z2 = 0;                                             // sum of pass estimates and of their squares
+  vector<double> Z2P(nCells, 0), Z2PP(nCells, 0);                   // sums of Z_b^2 p_b and Z_b^2 p_b^2
+
+  const int N = APPROX_PARTICLES;
+  std::mt19937 rng((uint32_t) seed);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  vector<uint8_t> xs((size_t) N * nCells), xsNext((size_t) N * nCells);
+  vector<double> lw(N), lwNext(N);
+  vector<int> nm(N), nmNext(N);
+  vector<double> w(N);
+  auto start = std::chrono::steady_clock::now();
+  SearchCounters counters;
+
+  for (int pass = 0; pass * N < APPROX_MAX_SAMPLES; ++pass) {
+    if (pass >= 2) {
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      if (elapsed.count() >= approxTimeMs)
+        break;
+    }
 
-  int C = (int) chain_sols.size();
+    fill(lw.begin(), lw.end(), 0.);
+    fill(nm.begin(), nm.end(), 0);
+    int alive = N;
+    for (int t = 0; t < nCells && alive > 0; ++t) {
+      int c = order[t];
+      for (int p = 0; p < N; ++p) {
+        if (lw[p] == -std::numeric_limits<double>::infinity())
+          continue;
+        counters.nodes += 1;
+        const uint8_t* x = &xs[(size_t) p * nCells];
+        bool can[2] = { true, true };
+        for (const GroupCheck& check : checks[t]) {
+          int placed = 0;
+          for (int a : check.assigned)
+            placed += x[a];
+          for (int v = 0; v <= 1; ++v) {
+            if (placed + v < check.lo || placed + v > check.hi)
+              can[v] = false;
+          }
+        }
+        if (!can[0] && !can[1]) {
+          lw[p] = -std::numeric_limits<double>::infinity();
+          counters.pruned += 1;
+          alive -= 1;
+          continue;
+        }
+        int v = can[1];
+        if (can[0] && can[1]) {
+          v = rng() & 1;
+          lw[p] += 1;
+        }
+        xs[(size_t) p * nCells + c] = (uint8_t) v;
+        nm[p] += v;
+      }
+      if (alive == 0)
+        break;
+
+      // Resample once the effective number of particles drops below N / 2
+      double maxLw = *std::max_element(lw.begin(), lw.end());
+      double sum = 0, sum2 = 0;
+      for (int p = 0; p < N; ++p) {
+        w[p] = std::exp2(lw[p] - maxLw);
+        sum += w[p];
+        sum2 += w[p] * w[p];
+      }
+      if (sum * sum >= sum2 * N / 2)
+        continue;
+      double u = uniform(rng) * sum / N, acc = 0;
+      for (int p = 0, q = 0; p < N; ++p) {
+        double target = u + p * sum / N;
+        while (q < N - 1 && acc + w[q] <= target)
+          acc += w[q++];
+        copy(xs.begin() + (size_t) q * nCells, xs.begin() + (size_t) (q + 1) * nCells,
+             xsNext.begin() + (size_t) p * nCells);
+        nmNext[p] = nm[q];
+        lwNext[p] = maxLw + std::log2(sum / N);
+      }
+      xs.swap(xsNext);
+      nm.swap(nmNext);
+      lw.swap(lwNext);
+      alive = N;
+    }
 
-  vector<vector<int>> cmines;
-  vector<int> offset;
-  vector<int> config;
-  int minMines;
-  combineChainMineCount(chain_sols, cmines, offset, config, minMines);
+    if (budget && budget->charge((uint64_t) N * nCells)) {
+      counters.stopped = true;
+      break;
+    }
+    if (alive == 0)
+      continue;
 
-  vector<int> weight(cmines.size(), 0);
-  int l = offset.size() <= 1 ? (int) config.size() : offset[1];
-  for (int i = 0; i < (int) cmines.size(); ++i) {
-    for (int j = 0; j < l; ++j)
-      weight[i] += cmines[i][j];
+    // The pass estimates the chain's count as 2^m * sum / N
+    double m = *std::max_element(lw.begin(), lw.end());
+    double sum = 0;
+    vector<double> Wb(nCells + 1, 0), Xb(nCells, 0);
+    for (int p = 0; p < N; ++p) {
+      double wp = std::exp2(lw[p] - m);
+      if (wp == 0)
+        continue;
+      sum += wp;
+      Wb[nm[p]] += wp;
+      const uint8_t* x = &xs[(size_t) p * nCells];
+      for (int c = 0; c < nCells; ++c)
+        Xb[c] += x[c] ? wp : 0;
+    }
+    double logZ = m + std::log2(sum / N);
+    if (logZ > top) {
+      double f = top == -std::numeric_limits<double>::infinity() ? 0 : std::exp2(top - logZ);
+      for (int k = 0; k <= nCells; ++k) {
+        W[k] *= f;
+        for (double& wx : WX[k])
+          wx *= f;
+      }
+      Z *= f;
+      Z2 *= f * f;
+      for (int c = 0; c < nCells; ++c) {
+        Z2P[c] *= f * f;
+        Z2PP[c] *= f * f;
+      }
+      top = logZ;
+    }
+    double zb = std::exp2(logZ - top);
+    double scale = zb / sum;
+    for (int p = 0; p < N; ++p) {
+      double wp = std::exp2(lw[p] - m);
+      if (wp == 0)
+        continue;
+      W[nm[p]] += wp * scale;
+      const uint8_t* x = &xs[(size_t) p * nCells];
+      for (int c = 0; c < nCells; ++c) {
+        if (x[c])
+          WX[nm[p]][c] += wp * scale;
+      }
+    }
+    Z += zb;
+    Z2 += zb * zb;
+    for (int c = 0; c < nCells; ++c) {
+      double pb = Xb[c] / sum;
+      Z2P[c] += zb * zb * pb;
+      Z2PP[c] += zb * zb * pb * pb;
+    }
   }
 
-  int low = 0, high = (int) cmines.size() - 1;
-  if (high + minMines > adjustedMines)
-    high = adjustedMines - minMines;
-  if (adjustedMines - (low + minMines) > (int) solver.noNeighbors.size())
-    low = adjustedMines - (int) solver.noNeighbors.size() - minMines;
+  out.relatedCells = relatedCells;
+  out.no_mines.clear();
+  out.freq_no_mines.clear();
+  out.freq_mines_pos.clear();
+  out.all_configs = ConfigSet(nCells);
+  out.search = counters;
+  out.approximate = true;
+  out.error.assign(nCells, 0.f);
+  if (counters.stopped)
+    return;
 
-  if (low > high || low < 0 || high < 0) {
-    mineConf.assign(h, vector<int>(w, -1));
+  // No particle got through: leave the chain unsolved
+  double topW = *std::max_element(W.begin(), W.end());
+  if (topW == 0) {
+    out.search.stopped = true;
     return;
   }
 
-  // Compute noMinesProb (same as generalSolve)
-  vector<double> noMinesProb(high - low + 1, 0.);
-  int sumW = 0;
-  for (int i = low; i <= high; ++i)
-    sumW += weight[i];
-
-  if (sumW == 0) {
-    noMinesProb[0] = 1.0;
-  } else {
-    vector<int> remaining_mines(high - low + 1);
-    vector<int> weight_slice(high - low + 1);
-    for (int i = low; i <= high; ++i) {
-      remaining_mines[i - low] = adjustedMines - (i + minMines);
-      weight_slice[i - low] = weight[i];
-    }
-    vector<double> p = computeNormalizedBinomials(solver.noNeighbors.size(), remaining_mines, weight_slice);
-    for (int i = 0; i <= high - low; ++i)
-      noMinesProb[i] = p[i];
-  }
-
-  // Step 5b: Sample total chain mine count from noMinesProb
-  std::discrete_distribution<int> totalDist(noMinesProb.begin(), noMinesProb.end());
-  int kIdx = totalDist(rng);
-  int totalChainMines = (kIdx + low) + minMines;
-  int remainingForNoNeighbors = adjustedMines - totalChainMines;
-
-  // Step 5c: Sample per-chain mine counts via backward DP
-  // dp[i][s] = weighted number of ways chains i..C-1 can sum to s mines
-  int maxBudget = totalChainMines + 1;
-  vector<vector<double>> dp(C + 1, vector<double>(maxBudget, 0.0));
-  dp[C][0] = 1.0;
-
-  for (int i = C - 1; i >= 0; --i) {
-    const ChainSolution& cs = chain_sols[i];
-    for (int s = 0; s < maxBudget; ++s) {
-      for (int j = 0; j < (int) cs.no_mines.size(); ++j) {
-        int m = cs.no_mines[j];
-        int rem = s - m;
-        if (rem >= 0 && rem < maxBudget)
-          dp[i][s] += (double) cs.freq_no_mines[j] * dp[i + 1][rem];
-      }
-    }
-  }
-
-  // Sample sequentially
-  vector<int> chosenMines(C);
-  int remaining = totalChainMines;
-  for (int i = 0; i < C; ++i) {
-    const ChainSolution& cs = chain_sols[i];
-    vector<double> weights;
-    vector<int> candidates;
-    for (int j = 0; j < (int) cs.no_mines.size(); ++j) {
-      int m = cs.no_mines[j];
-      int rem = remaining - m;
-      if (rem >= 0 && rem < maxBudget) {
-        double w = (double) cs.freq_no_mines[j] * dp[i + 1][rem];
-        if (w > 0) {
-          weights.push_back(w);
-          candidates.push_back(j);
-        }
-      }
-    }
-    std::discrete_distribution<int> chainDist(weights.begin(), weights.end());
-    int chosen = chainDist(rng);
-    int jIdx = candidates[chosen];
-    chosenMines[i] = chain_sols[i].no_mines[jIdx];
-    remaining -= chosenMines[i];
+  out.scale = (int) std::floor(top);
+  double factor = std::exp2(top - out.scale);
+  for (int k = 0; k <= nCells; ++k) {
+    if (W[k] == 0)
+      continue;
+    vector<double> mines(nCells);
+    for (int c = 0; c < nCells; ++c)
+      mines[c] = WX[k][c] * factor;
+    out.no_mines.push_back(k);
+    out.freq_no_mines.push_back(W[k] * factor);
+    out.freq_mines_pos.push_back(mines);
   }
 
-  // Step 5d: Sample per-chain configuration
-  for (int i = 0; i < C; ++i) {
-    const ChainSolution& cs = chain_sols[i];
-    int targetMines = chosenMines[i];
+  // Variance of the pass-weighted mean p = sum(Z_b p_b) / sum(Z_b)
+  for (int c = 0; c < nCells; ++c) {
+    double wx = 0;
+    for (int k = 0; k <= nCells; ++k)
+      wx += WX[k][c];
+    double p = wx / Z;
+    double var = (Z2PP[c] - 2 * p * Z2P[c] + p * p * Z2) / (Z * Z);
+    out.error[c] = (float) (std::sqrt(max(var, 0.)) * 100);
+  }
+}
+
+// Counts the configurations of a chain with the engine selected by chainEngine,
+// for callers that only need the frequencies. CHAIN_ENGINE_AUTO sweeps long chains
+// with a narrow frontier, splits those too wide to sweep at a narrow cut, samples
+// those of at least approxMinCells cells that cannot be split and enumerates
+// everything else.
+Solver::ChainSolution Solver::countChain(const vector<Group*>& chain, SolveBudget* budget) const {
+  ChainSolution out;
+  if (chainEngine == CHAIN_ENGINE_FRONTIER && solveChainFrontier(chain, out, 63, budget))
+    return out;
+
+  if (chainEngine == CHAIN_ENGINE_APPROX) {
+    solveChainApprox(chain, out, budget);
+    return out;
+  }
 
-    // Filter all_configs to those matching targetMines
-    vector<int> matching;
-    for (int ci = 0; ci < (int) cs.all_configs.size(); ++ci) {
-      int sum = 0;
-      for (int v : cs.all_configs[ci])
-        sum += v;
-      if (sum == targetMines)
-        matching.push_back(ci);
+  if (chainEngine == CHAIN_ENGINE_AUTO) {
+    CellSet relatedCells;
+    for (Group* g : chain)
+      relatedCells.unite(g->groupcells);
+    int nCells = (int) relatedCells.size();
+    if (nCells >= FRONTIER_MIN_CELLS && solveChainFrontier(chain, out, FRONTIER_MAX_WIDTH, budget))
+      return out;
+    if (nCells >= FRONTIER_MIN_CELLS && solveChainSplit(chain, out, budget))
+      return out;
+    if (nCells >= approxMinCells) {
+      solveChainApprox(chain, out, budget);
+      return out;
     }
+  }
 
-    // Pick one uniformly at random
-    std::uniform_int_distribution<int> configDist(0, (int) matching.size() - 1);
-    int pickedIdx = matching[configDist(rng)];
-    const vector<int>& pickedConfig = cs.all_configs[pickedIdx];
+  return solveChain(chain, false, budget);
+}
 
-    // Map to board positions using relatedCells iteration order
-    int idx = 0;
-    for (Cell* cell : cs.relatedCells) {
-      mineConf[cell->r][cell->c] = pickedConfig[idx];
-      idx++;
+Solver::ChainCache& Solver::ChainCache::shared() {
+  static ChainCache cache;
+  return cache;
+}
+
+// Every group as a header word (cell count, minV, maxV) followed by its cells as
+// (row, column) offsets from the chain's first cell, groups in sorted order.
+vector<uint64_t> Solver::ChainCache::signature(const vector<Group*>& chain) {
+  const Cell* anchor = nullptr;
+  for (const Group* g : chain) {
+    const Cell* first = *g->groupcells.begin();
+    if (anchor == nullptr || first->id < anchor->id)
+      anchor = first;
+  }
+
+  vector<vector<uint64_t>> encoded;
+  encoded.reserve(chain.size());
+  for (const Group* g : chain) {
+    vector<uint64_t> words;
+    words.push_back(((uint64_t) g->groupcells.size() << 16) | ((uint64_t) g->minV << 8) | (uint64_t) g->maxV);
+    for (const Cell* c : g->groupcells)
+      words.push_back(((uint64_t) (uint32_t) (c->r - anchor->r) << 32) | (uint32_t) (c->c - anchor->c));
+    encoded.push_back(std::move(words));
+  }
+  sort(encoded.begin(), encoded.end());
+
+  vector<uint64_t> key;
+  for (const vector<uint64_t>& words : encoded)
+    key.insert(key.end(), words.begin(), words.end());
+  return key;
+}
+
+size_t Solver::ChainCache::SignatureHash::operator()(const vector<uint64_t>& key) const {
+  size_t h = key.size();
+  for (uint64_t w : key)
+    h ^= std::hash<uint64_t>{}(w) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
+bool Solver::ChainCache::find(const vector<Group*>& chain, const vector<uint64_t>& key, bool needConfigs,
+                              bool allowApprox, ChainSolution& out) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end())
+      return false;
+    const CachedChain& entry = *it->second;
+    if ((needConfigs && entry.configs.empty()) || (entry.solution.approximate && !allowApprox))
+      return false;
+
+    entries.splice(entries.begin(), entries, it->second);
+    out = entry.solution;
+    if (needConfigs)
+      out.all_configs = entry.configs;
+  }
+
+  out.relatedCells = CellSet();
+  for (const Group* g : chain)
+    out.relatedCells.unite(g->groupcells);
+  return true;
+}
+
+// The signature is counted twice, as it is also the key of the index.
+size_t Solver::ChainCache::CachedChain::byteSize() const {
+  size_t out = sizeof(CachedChain) + 2 * signature.capacity() * sizeof(uint64_t);
+  out += solution.no_mines.capacity() * sizeof(int);
+  out += solution.freq_no_mines.capacity() * sizeof(double);
+  for (const vector<double>& freq : solution.freq_mines_pos)
+    out += sizeof(freq) + freq.capacity() * sizeof(double);
+  out += solution.error.capacity() * sizeof(float);
+  return out + configs.byteSize();
+}
+
+void Solver::ChainCache::store(const vector<uint64_t>& key, const ChainSolution& solution) {
+  CachedChain entry;
+  entry.signature = key;
+  entry.solution = solution;
+  entry.solution.relatedCells = CellSet();
+  if (entry.solution.all_configs.size() <= CHAIN_CACHE_MAX_CONFIGS)
+    entry.configs = std::move(entry.solution.all_configs);
+  entry.solution.all_configs = ConfigSet();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(key);
+  if (it != index.end()) {
+    // Keep configurations stored by an earlier caller that asked for them
+    if (entry.configs.empty())
+      entry.configs = std::move(it->second->configs);
+    totalBytes -= it->second->bytes;
+    entries.erase(it->second);
+    index.erase(it);
+  }
+  entry.bytes = entry.byteSize();
+  if (entry.bytes > CHAIN_CACHE_BYTES)
+    return;
+  totalBytes += entry.bytes;
+  entries.push_front(std::move(entry));
+  index[key] = entries.begin();
+
+  while (totalBytes > CHAIN_CACHE_BYTES) {
+    totalBytes -= entries.back().bytes;
+    index.erase(entries.back().signature);
+    entries.pop_back();
+  }
+}
+
+void Solver::ChainCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  index.clear();
+  entries.clear();
+  totalBytes = 0;
+}
+
+// Solves independent chains on the shared thread pool, or takes their solutions
+// from the chain cache. Solutions are returned in chain order, or nothing if the
+// budget ran out.
+vector<Solver::ChainSolution> Solver::solveChains(const vector<vector<Group*>>& chains, bool keepConfigs,
+                                                  SolveBudget* budget) const {
+  int n = (int) chains.size();
+  ChainCache& cache = ChainCache::shared();
+  vector<vector<uint64_t>> keys(n);
+  vector<ChainSolution> out(n);
+  vector<int> toSolve;
+  for (int i = 0; i < n; ++i) {
+    keys[i] = ChainCache::signature(chains[i]);
+    if (!cache.find(chains[i], keys[i], keepConfigs, false, out[i]))
+      toSolve.push_back(i);
+  }
+
+  ThreadPool::shared().parallelFor((int) toSolve.size(), [&](int k) {
+    out[toSolve[k]] = solveChain(chains[toSolve[k]], keepConfigs, budget);
+  });
+
+  if (budget && budget->exhausted())
+    return vector<ChainSolution>();
+  for (int i : toSolve)
+    cache.store(keys[i], out[i]);
+  return out;
+}
+
+// Counts the configurations of every chain like countChain, but takes the solution of
+// a chain from the chain cache when the same constraints were counted before. Sampled
+// solutions are only taken when this solver's engine would sample too. Returns nothing
+// if the budget ran out or a chain could not be sampled; incomplete solutions are not
+// stored.
+vector<Solver::ChainSolution> Solver::reuseOrSolveChains(const vector<vector<Group*>>& chains, SolveBudget* budget) {
+  int n = (int) chains.size();
+  ChainCache& cache = ChainCache::shared();
+  bool allowApprox = chainEngine == CHAIN_ENGINE_AUTO || chainEngine == CHAIN_ENGINE_APPROX;
+  vector<vector<uint64_t>> keys(n);
+  vector<ChainSolution> out(n);
+  vector<int> toSolve;
+  for (int i = 0; i < n; ++i) {
+    keys[i] = ChainCache::signature(chains[i]);
+    if (!cache.find(chains[i], keys[i], false, allowApprox, out[i]))
+      toSolve.push_back(i);
+  }
+
+  ThreadPool::shared().parallelFor((int) toSolve.size(), [&](int k) {
+    out[toSolve[k]] = countChain(chains[toSolve[k]], budget);
+  });
+
+  bool stopped = budget && budget->exhausted();
+  for (int i : toSolve)
+    stopped |= out[i].search.stopped;
+  if (stopped)
+    return vector<ChainSolution>();
+
+  stats.chainsReused += n - (int) toSolve.size();
+  for (int i : toSolve) {
+    const ChainSolution& cs = out[i];
+    cache.store(keys[i], cs);
+    stats.chainsSolved += 1;
+    stats.searchNodes += cs.search.nodes;
+    stats.searchPruned += cs.search.pruned;
+    if (cs.approximate) {
+      stats.chainsSampled += 1;
+      continue;
     }
+    double total = 0;
+    for (double f : cs.freq_no_mines)
+      total += f;
+    total = std::ldexp(total, cs.scale);
+    uint64_t configs = total < 0x1p64 ? (uint64_t) total : UINT64_MAX;
+    stats.configurations += min(configs, UINT64_MAX - stats.configurations);
+    stats.maxChainConfigurations = max(stats.maxChainConfigurations, configs);
   }
+  return out;
+}
+
+// Updates groups to account for newly solved cells: disables groups fully covered
+// by solved cells and creates reduced sub-groups for partially covered ones, adjusting
+// mine counts based on whether solved cells were mines or safe. Only groups touching
+// the cells solved by the last apply() are visited. Returns false on contradiction.
+bool Solver::filter() {
+  TRACE_SCOPE("filter");
+  vector<Cell*> solvedNow;
+  solvedNow.swap(newlySolved);
+
+  for (Cell* sc : solvedNow) {
+    // Reduced groups never contain a solved cell, so sc->groups does not grow here
+    for (Group* g : sc->groups) {
+      if (g->disabled)
+        continue;
+      CellSet intersect = g->intersect(solvedCells);
+
+      g->disabled = true;
+      if (intersect.size() == g->groupcells.size())
+        continue;
+
+      Group* newG = pool.create(g->subtract(solvedCells));
+      newG->minV = g->minV;
+      newG->maxV = g->maxV;
+      for (Cell* c : intersect) {
+        if (c->minePerc == 100.f) {
+          newG->minV -= 1;
+          newG->maxV -= 1;
+
+          if (newG->maxV < 0)
+            return false;
+
+          if (newG->minV < 0)
+            newG->minV = 0;
+        }
+      }
 
-  // Step 5e: Sample noNeighbor mines
-  if (!solver.noNeighbors.empty()) {
-    int n = (int) solver.noNeighbors.size();
-    vector<bool> isMineVec(n, false);
-    for (int i = 0; i < remainingForNoNeighbors && i < n; ++i)
-      isMineVec[i] = true;
-    std::shuffle(isMineVec.begin(), isMineVec.end(), rng);
-    for (int i = 0; i < n; ++i) {
-      Cell* cell = solver.noNeighbors[i];
-      mineConf[cell->r][cell->c] = isMineVec[i] ? 1 : 0;
+      addGroup(newG);
     }
   }
+
+  filterTrivial();
+  return true;
+}
+
+// Marks every undiscovered cell that was not deduced as unpredicted, for results
+// cut short by the budget or by a chain that could not be sampled.
+void Solver::markUnresolved() {
+  canEndgame = false;
+  numConfigurations = 0;
+  for (Cell& c : board.data) {
+    if (c.value == CELL_UNDISCOVERED && !solvedCells.contains(&c))
+      c.minePerc = -1.f;
+  }
+}
+
+// Removes a cell that became known from every group containing it, replacing each
+// group by the group over its remaining cells with the bounds adjusted for whether
+// the cell is a mine. Returns false on contradiction.
+bool Solver::removeCell(Cell* cell, bool isMine) {
+  vector<Group*> containing;
+  containing.swap(cell->groups);
+
+  for (Group* g : containing) {
+    if (g->disabled)
+      continue;
+    g->disabled = true;
+
+    int minV = max(g->minV - (int) isMine, 0);
+    int maxV = g->maxV - (int) isMine;
+    if (maxV < 0 || minV > (int) g->groupcells.size() - 1)
+      return false;
+    if (g->groupcells.size() == 1)
+      continue;
+
+    CellSet rest = g->groupcells;
+    rest.erase(cell);
+    Group* newG = pool.create(rest);
+    newG->minV = minV;
+    newG->maxV = maxV;
+    addGroup(newG);
+  }
+
+  return true;
+}
+
+// Applies a newly revealed number to an already solved board: the cell leaves every
+// group it was part of and its number becomes a new group. Leaves the solver in the
+// state a fresh Solver on the updated board would be in before solving, so the next
+// generalSolve() only propagates what changed. Returns false if the reveal contradicts
+// the current deductions, in which case the solver must be rebuilt.
+bool Solver::revealCell(int row, int col, int value) {
+  Cell* cell = board.getCellMutable(row, col);
+  bool solvedBefore = solvedCells.contains(cell);
+  if (value < 0 || (solvedBefore && cell->minePerc == 100.f))
+    return false;
+  if (cell->value >= 0 || cell->value == CELL_FLAG)
+    return false;
+
+  if (cell->value == CELL_UNDISCOVERED || solvedBefore)
+    board.unsolved -= 1;
+  solvedCells.erase(cell);
+  cell->value = CELL_NUMBER(value);
+  cell->minePerc = 0.f;
+
+  if (!removeCell(cell, false))
+    return false;
+
+  Group* group = pool.create(row, col, board);
+  if (group->maxV < 0 || group->minV > (int) group->groupcells.size())
+    valid_input = false;
+  if (group->groupcells.size() == 0 && group->minV == 0)
+    pool.release(group);
+  else
+    addGroup(group);
+
+  noNeighbors = board.noNeighborsCells();
+  return valid_input;
+}
+
+// Applies a newly placed flag, treating the cell as a known mine that is no longer
+// part of the unsolved mine count. Returns false on contradiction.
+bool Solver::flagCell(int row, int col) {
+  Cell* cell = board.getCellMutable(row, col);
+  bool solvedBefore = solvedCells.contains(cell);
+  if (solvedBefore && cell->minePerc == 0.f)
+    return false;
+  if (cell->value >= 0 || (cell->value == CELL_FLAG && !solvedBefore))
+    return false;
+
+  if (cell->value == CELL_UNDISCOVERED || solvedBefore)
+    board.unsolved -= 1;
+  solvedCells.erase(cell);
+  cell->value = CELL_FLAG;
+  cell->minePerc = 100.f;
+
+  if (!removeCell(cell, true))
+    return false;
+
+  noNeighbors = board.noNeighborsCells();
+  return true;
+}
+
+// Draws one mine layout of a solved board. Callers drawing many layouts of the same
+// board should build a ConfigSampler once and draw from it instead.
+void Solver::sampleConfiguration(const Solver& solver, int mines,
+                                 vector<vector<int>>& mineConf, std::mt19937& rng) {
+  TRACE_SCOPE("sampleConfiguration");
+  ConfigSampler(solver, mines).sample(mineConf, rng);
 }
 
 float Solver::tryWarp(int mines, int row, int col, bool isMine, vector<vector<int>>& mineConf) {
@@ -2,52 +2,165 @@
 
 #include "Board.h"
 #include "Group.h"
+#include "GroupPool.h"
+#include "ConfigSet.h"
+#include "SolverStats.h"
+#include "SolveBudget.h"
 #include "Utils.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 #include <iostream>
 #include <queue>
 #include <stack>
 #include <map>
+#include <list>
+#include <mutex>
 #include <unordered_map>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <random>
+#include <numeric>
+#include <limits>
 using std::cout;
 using std::queue;
 using std::stack;
 using std::map;
+using std::list;
 using std::unordered_map;
 
 class Solver {
 private:
-  mutable unordered_map<uint32_t, vector<vector<int>>> combinationCache;
-  vector<vector<int>> getCombinations(int n, int r) const;
-  void solveRec(const vector<Group*>& chain, const vector<int>& order, const vector<vector<int>>& group_cells_id,
-                vector<int>& freq_no_mines, vector<vector<int>>& freq_mines_pos,
-                vector<int>& sol, vector<vector<int>>& all_configs, int id = 0) const;
-  static void sampleConfiguration(const Solver& solver, int mines,
-                                  vector<vector<int>>& mineConf, std::mt19937& rng);
+  void init();
+  static void indexChainCells(const vector<Group*>& chain, CellSet& relatedCells,
+                              vector<vector<int>>& group_cells_id);
+  bool removeCell(Cell* cell, bool isMine);
+  void markUnresolved();
+
+  // State of the enumeration of one chain, see solveRec()
+  struct SearchGroup {
+    int placed; // mines among the assigned cells
+    int open;   // unassigned cells
+    int minV;
+    int maxV;
+  };
+  struct ChainSearch {
+    const vector<vector<int>>* group_cells_id;
+    vector<vector<int>> cellGroups; // groups containing every cell
+    vector<SearchGroup> groups;
+    int openGroups;                 // groups with unassigned cells
+    vector<uint64_t> assigned;
+    vector<uint64_t> mines;
+    int nMines;
+    vector<double> freq_no_mines;
+    vector<vector<double>> freq_mines_pos;
+    ConfigSet* all_configs;
+    SearchCounters counters;
+    SolveBudget* budget;
+  };
+  void solveRec(ChainSearch& search) const;
+  template <int C>
+  void fillGroup(ChainSearch& search, const int* to_assign, int mn, int mx) const;
 
 public:
   struct ChainSolution {
-    set<Cell*> relatedCells;
+    CellSet relatedCells;
     vector<int> no_mines;
-    vector<int> freq_no_mines;
-    vector<vector<int>> freq_mines_pos;
-    vector<vector<int>> all_configs;
+    // Configurations by mine count, and by mine count and mine cell, are these
+    // times 2^scale. Enumerated counts are exact; they stay within a double's
+    // range however many configurations a chain has.
+    vector<double> freq_no_mines;
+    vector<vector<double>> freq_mines_pos;
+    int scale = 0;
+    ConfigSet all_configs; // only filled when asked for, see solveChain()
+    SearchCounters search;
+    // Set by solveChainApprox: the counts are estimates, and error holds the
+    // standard error of every cell's mine probability within the chain, in percent.
+    bool approximate = false;
+    vector<float> error;
+  };
+
+  // Scratch state of one probability computation over the chains of the board,
+  // owned by the caller so that concurrent solves share nothing.
+  struct SolveContext {
+    vector<ChainSolution> chain_sols;
+    vector<vector<double>> cmines; // [chain mines - minMines][chain slot], see combineChainMineCount
+    vector<double> weight;         // [chain mines - minMines]
+    int weightScale;               // cmines and weight are relative to 2^weightScale
+    vector<int> offset;            // first slot of every chain
+    int minMines;
+    int low, high;                 // chain mine counts still possible, relative to minMines
+    double totalWeight;            // sum of weight over [low, high]
+    vector<double> noMinesProb;    // probability of every count in [low, high]
+  };
+
+  // Solutions of recently counted chains, shared by every solver. A chain is keyed
+  // by the cells of its groups relative to its first cell, and their minV / maxV, so
+  // the same constraints met again, on this board or another and wherever they sit,
+  // are looked up instead of counted. Solutions index cells in row-major order, which
+  // a translation keeps. Past CHAIN_CACHE_BYTES the least recently used entries are dropped.
+  class ChainCache {
+  public:
+    static ChainCache& shared();
+    static vector<uint64_t> signature(const vector<Group*>& chain);
+
+    // Copies the stored solution of chain into out. Misses when needConfigs is set
+    // and the configurations were not kept, or when the solution is approximate and
+    // allowApprox is not set.
+    bool find(const vector<Group*>& chain, const vector<uint64_t>& key, bool needConfigs,
+              bool allowApprox, ChainSolution& out);
+    void store(const vector<uint64_t>& key, const ChainSolution& solution);
+    void clear();
+
+  private:
+    struct CachedChain {
+      vector<uint64_t> signature;
+      ChainSolution solution; // without relatedCells and all_configs
+      ConfigSet configs;      // kept up to CHAIN_CACHE_MAX_CONFIGS configurations
+      size_t bytes;           // estimated memory held by the entry and its index key
+
+      size_t byteSize() const;
+    };
+    struct SignatureHash {
+      size_t operator()(const vector<uint64_t>& key) const;
+    };
+    list<CachedChain> entries; // most recently used first
+    unordered_map<vector<uint64_t>, list<CachedChain>::iterator, SignatureHash> index;
+    size_t totalBytes = 0;
+    std::mutex mutex;
   };
 
   Board board;
+  GroupPool pool;
   vector<Group*> groups;
-  set<Cell*> solvedCells;
+  CellSet solvedCells;
   bool solved;
   bool valid_input;
   bool canEndgame;
+  uint64_t numConfigurations; // counted by the last generalSolve(), capped at CONFIG_COUNT_BOUND
+  SolverStats stats;
+  int chainEngine; // CHAIN_ENGINE_*
+  int approxMinCells; // see APPROX_MIN_CELLS
+  int approxTimeMs;   // see APPROX_TIME_MS
   vector<Cell*> noNeighbors;
-  vector<Cell*> groupedCells;
+
+  // Propagation worklists: groups created or tightened since they were last
+  // crossed / synced, groups waiting to be checked by apply(), and cells
+  // solved since the last filter().
+  vector<Group*> crossQueue;
+  vector<Group*> syncQueue;
+  vector<Group*> applyQueue;
+  vector<Cell*> newlySolved;
+
+  // Live groups keyed by CellSet::hash() of their cells, so that a derived group
+  // over an already known cell set is merged into the existing group.
+  std::unordered_multimap<size_t, Group*> groupIndex;
+  uint64_t nextSerial;
   
   Solver(vector<vector<int>> rd);
-  void addGroup(Group* g);
+  void reset(vector<vector<int>> rd);
+  Group* addGroup(Group* g);
+  void queueGroup(Group* g);
   void crossAllGroups();
   void filterTrivial();
   void cleanDisabled();
@@ -55,14 +168,29 @@ public:
 
   bool apply();
   bool syncAllGroups();
+  bool eliminate();
   bool isDone() const;
-  bool iterativeSolve();
-  bool generalSolve(int = -1);
+  bool iterativeSolve(SolveBudget* budget = nullptr);
+  bool generalSolve(int = -1, SolveBudget* budget = nullptr);
+  bool weighChains(int mines, SolveContext& ctx) const;
+
+  bool revealCell(int row, int col, int value);
+  bool flagCell(int row, int col);
 
   void printBoard() const;
   void printProb() const;
   vector<vector<Group*>> getGroupChains() const;
-  ChainSolution solveChain(const vector<Group*>&) const;
+  ChainSolution solveChain(const vector<Group*>&, bool keepConfigs = false, SolveBudget* budget = nullptr) const;
+  bool solveChainFrontier(const vector<Group*>&, ChainSolution& out, int maxWidth = 63,
+                          SolveBudget* budget = nullptr) const;
+  bool solveChainSplit(const vector<Group*>&, ChainSolution& out, SolveBudget* budget = nullptr) const;
+  void solveChainApprox(const vector<Group*>&, ChainSolution& out, SolveBudget* budget = nullptr) const;
+  ChainSolution countChain(const vector<Group*>&, SolveBudget* budget = nullptr) const;
+  vector<ChainSolution> solveChains(const vector<vector<Group*>>&, bool keepConfigs = false,
+                                    SolveBudget* budget = nullptr) const;
+  vector<ChainSolution> reuseOrSolveChains(const vector<vector<Group*>>&, SolveBudget* budget = nullptr);
   float tryWarp(int mines, int row, int col, bool isMine, vector<vector<int>>& mineConf);
+  static void sampleConfiguration(const Solver& solver, int mines,
+                                  vector<vector<int>>& mineConf, std::mt19937& rng);
 };
 
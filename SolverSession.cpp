@@ -0,0 +1,47 @@
+#include "SolverSession.h"
+
+SolverSession::SolverSession(vector<vector<int>> rd) : raw(rd), solver(rd) {
+  consistent = true;
+}
+
+// Applies the updates to the session board and re-solves it with the given number
+// of unflagged mines. Returns false if an update is out of range or the board is
+// not solvable.
+bool SolverSession::update(const vector<CellUpdate>& updates, int mines) {
+  for (const CellUpdate& u : updates) {
+    if (!solver.board.isValidCoord(u.row, u.col))
+      return false;
+  }
+
+  for (const CellUpdate& u : updates) {
+    int before = raw[u.row][u.col];
+    raw[u.row][u.col] = u.value;
+    if (!consistent || before == u.value)
+      continue;
+
+    if (before != CELL_UNDISCOVERED)
+      consistent = false;
+    else if (u.value >= CELL_NUMBER(0))
+      consistent = solver.revealCell(u.row, u.col, u.value);
+    else if (u.value == CELL_FLAG)
+      consistent = solver.flagCell(u.row, u.col);
+    else
+      consistent = false;
+  }
+
+  return solve(mines);
+}
+
+// Solves the current session board, rebuilding the solver first if an earlier
+// update or solve left it unusable.
+bool SolverSession::solve(int mines) {
+  if (!consistent) {
+    solver.reset(raw);
+    consistent = true;
+  }
+
+  bool valid = solver.generalSolve(mines);
+  if (!valid)
+    consistent = false;
+  return valid;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Solver.h"
+#include <vector>
+using std::vector;
+
+struct CellUpdate {
+  int row;
+  int col;
+  int value; // revealed number, or CELL_FLAG
+};
+
+// Keeps one Solver alive across the moves of a game. Newly revealed numbers and
+// flags are applied to the already solved state, so only the groups and chains
+// they touch are derived and enumerated again. Updates that cannot be applied
+// incrementally (changed numbers, removed flags, contradictions) rebuild the
+// solver from the raw board instead.
+class SolverSession {
+public:
+  vector<vector<int>> raw;
+  Solver solver;
+  bool consistent; // solver state matches raw and can take further updates
+
+  SolverSession(vector<vector<int>> rd);
+
+  bool update(const vector<CellUpdate>& updates, int mines);
+  bool solve(int mines);
+};
@@ -0,0 +1,52 @@
+#include "SolverStats.h"
+
+SolverStats::SolverStats() {
+  clear();
+}
+
+void SolverStats::clear() {
+  groupsCreated = 0;
+  groupsMerged = 0;
+  groupsReleased = 0;
+  crossCalls = 0;
+  iterativeRounds = 0;
+  chainsSolved = 0;
+  chainsReused = 0;
+  searchNodes = 0;
+  searchPruned = 0;
+  configurations = 0;
+  maxChainConfigurations = 0;
+  chainsSampled = 0;
+  cellsEliminated = 0;
+}
+
+void SolverStats::writeTo(double* out) const {
+  const uint64_t values[SOLVER_STATS_COUNT] = {
+    groupsCreated, groupsMerged, groupsReleased, crossCalls, iterativeRounds,
+    chainsSolved, chainsReused, searchNodes, searchPruned, configurations, maxChainConfigurations,
+    chainsSampled, cellsEliminated
+  };
+  for (int i = 0; i < SOLVER_STATS_COUNT; ++i)
+    out[i] = (double) values[i];
+}
+
+EndgameStats::EndgameStats() {
+  clear();
+}
+
+void EndgameStats::clear() {
+  configurations = 0;
+  cells = 0;
+  memoHits = 0;
+  memoMisses = 0;
+  memoSize = 0;
+  partitions = 0;
+}
+
+void EndgameStats::writeTo(double* out) const {
+  const uint64_t values[ENDGAME_STATS_COUNT] = {
+    configurations, cells, memoHits, memoMisses, memoSize, partitions
+  };
+  for (int i = 0; i < ENDGAME_STATS_COUNT; ++i)
+    out[i] = (double) values[i];
+}
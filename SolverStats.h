@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+// Work done while enumerating one chain: search nodes visited, and the ones cut
+// off because a group could no longer be satisfied.
+struct SearchCounters {
+  uint64_t nodes;
+  uint64_t pruned;
+  bool stopped; // the solve ran out of budget, the results are incomplete
+
+  SearchCounters() : nodes(0), pruned(0), stopped(false) {}
+};
+
+// Counters collected by a Solver over its lifetime (since construction or the last
+// reset()). They are cheap to keep and meant to tell why a board was slow: too many
+// groups, a large enumeration, or neither.
+struct SolverStats {
+  uint64_t groupsCreated;    // groups added to the solver
+  uint64_t groupsMerged;     // derived groups merged into an existing group over the same cells
+  uint64_t groupsReleased;   // disabled groups handed back to the pool
+  uint64_t crossCalls;       // Group::cross() calls
+  uint64_t iterativeRounds;  // cross/sync/apply rounds of iterativeSolve()
+  uint64_t chainsSolved;     // chains enumerated by generalSolve()
+  uint64_t chainsReused;     // chains whose previous solution was reused
+  uint64_t searchNodes;      // enumeration nodes over all solved chains
+  uint64_t searchPruned;     // enumeration nodes cut off
+  uint64_t configurations;   // valid configurations over all chains counted exactly
+  uint64_t maxChainConfigurations;
+  uint64_t chainsSampled;    // chains estimated by sampling instead of counted exactly
+  uint64_t cellsEliminated;  // cells settled by Solver::eliminate()
+
+  SolverStats();
+  void clear();
+  // Writes the counters in declaration order, as doubles for the C API. Callers
+  // index the output, so new counters go last:
+  //   0 groupsCreated, 1 groupsMerged, 2 groupsReleased, 3 crossCalls,
+  //   4 iterativeRounds, 5 chainsSolved, 6 chainsReused, 7 searchNodes,
+  //   8 searchPruned, 9 configurations, 10 maxChainConfigurations,
+  //   11 chainsSampled, 12 cellsEliminated
+  void writeTo(double* out) const;
+};
+#define SOLVER_STATS_COUNT 13
+
+// Counters of one EndgameSolver::solveEndgame() call.
+struct EndgameStats {
+  uint64_t configurations;   // configurations the search starts from
+  uint64_t cells;            // cells the search can click
+  uint64_t memoHits;
+  uint64_t memoMisses;       // states searched
+  uint64_t memoSize;
+  uint64_t partitions;       // observation partitions evaluated
+
+  EndgameStats();
+  void clear();
+  void writeTo(double* out) const;
+};
+#define ENDGAME_STATS_COUNT 6
@@ -0,0 +1,96 @@
+#include "ThreadPool.h"
+#include "Macros.h"
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define THREADPOOL_NO_THREADS
+#endif
+
+// `threads` counts the calling thread, which always takes part in the loop.
+ThreadPool::ThreadPool(int threads) {
+  job = nullptr;
+  jobSize = 0;
+  next = 0;
+  active = 0;
+  generation = 0;
+  stopping = false;
+  busy = false;
+
+#ifndef THREADPOOL_NO_THREADS
+  for (int i = 1; i < threads; ++i)
+    workers.emplace_back(&ThreadPool::workerLoop, this);
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread& t : workers)
+    t.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+  static ThreadPool pool(SOLVER_THREADS > 0 ? SOLVER_THREADS : (int) std::thread::hardware_concurrency());
+  return pool;
+}
+
+int ThreadPool::size() const {
+  return (int) workers.size() + 1;
+}
+
+// Calls fn(i) for every i in [0, n) and returns once all calls finished.
+void ThreadPool::parallelFor(int n, const std::function<void(int)>& fn) {
+  if (n <= 0)
+    return;
+  if (workers.empty() || n == 1 || busy.exchange(true)) {
+    for (int i = 0; i < n; ++i)
+      fn(i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &fn;
+    jobSize = n;
+    next = 0;
+    active = (int) workers.size();
+    generation += 1;
+  }
+  wake.notify_all();
+
+  runJob();
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+  }
+  busy = false;
+}
+
+void ThreadPool::workerLoop() {
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+    if (stopping)
+      return;
+    seen = generation;
+
+    lock.unlock();
+    runJob();
+    lock.lock();
+
+    active -= 1;
+    if (active == 0)
+      done.notify_one();
+  }
+}
+
+void ThreadPool::runJob() {
+  int i;
+  while ((i = next.fetch_add(1)) < jobSize)
+    (*job)(i);
+}
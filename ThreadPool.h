@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+using std::vector;
+
+// Fixed set of worker threads running index-parallel loops. Indices are handed
+// out one at a time, so uneven work items balance themselves. Only one loop runs
+// on the pool at a time: a parallelFor issued while another one is running (for
+// instance from inside a worker) simply runs on the calling thread.
+class ThreadPool {
+public:
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  static ThreadPool& shared();
+
+  int size() const;
+  void parallelFor(int n, const std::function<void(int)>& fn);
+
+private:
+  vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::atomic<bool> busy; // a loop is running; nested and concurrent loops run serially
+
+  const std::function<void(int)>* job;
+  int jobSize;
+  std::atomic<int> next;
+  int active;
+  uint64_t generation;
+  bool stopping;
+
+  void workerLoop();
+  void runJob();
+};
@@ -0,0 +1,69 @@
+#include "Trace.h"
+
+#ifdef SOLVER_TRACE
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+struct TraceEvent {
+  const char* name;
+  int tid;
+  double start; // microseconds since the first span
+  double duration;
+};
+
+static std::mutex traceMutex;
+static std::vector<TraceEvent> traceEvents;
+static std::atomic<int> nextTraceTid(1);
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+static double traceNow() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+// Small per-thread ids keep the trace viewer's thread lanes readable.
+static int traceTid() {
+  thread_local int tid = nextTraceTid++;
+  return tid;
+}
+
+TraceSpan::TraceSpan(const char* name) : name(name), start(traceNow()) {}
+
+TraceSpan::~TraceSpan() {
+  double end = traceNow();
+  TraceEvent event = { name, traceTid(), start, end - start };
+  std::lock_guard<std::mutex> lock(traceMutex);
+  traceEvents.push_back(event);
+}
+
+void traceReset() {
+  std::lock_guard<std::mutex> lock(traceMutex);
+  traceEvents.clear();
+}
+
+std::string traceToJson() {
+  std::lock_guard<std::mutex> lock(traceMutex);
+  std::string out = "{\"traceEvents\":[";
+  char buf[256];
+  for (size_t i = 0; i < traceEvents.size(); ++i) {
+    const TraceEvent& e = traceEvents[i];
+    snprintf(buf, sizeof(buf), "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+             i == 0 ? "" : ",", e.name, e.tid, e.start, e.duration);
+    out += buf;
+  }
+  out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return out;
+}
+
+bool traceWriteFile(const char* path) {
+  FILE* f = fopen(path, "w");
+  if (!f)
+    return false;
+  std::string json = traceToJson();
+  bool ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+  fclose(f);
+  return ok;
+}
+#endif
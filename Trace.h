@@ -0,0 +1,35 @@
+#pragma once
+
+// Scoped tracing spans written as Chrome trace events (chrome://tracing, Perfetto).
+// Only compiled in when SOLVER_TRACE is defined; otherwise TRACE_SCOPE expands to
+// nothing and the rest of this header is empty.
+#ifdef SOLVER_TRACE
+#include <string>
+
+// Records one complete ("X") event from construction to destruction, on the
+// calling thread.
+class TraceSpan {
+public:
+  explicit TraceSpan(const char* name);
+  ~TraceSpan();
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+  const char* name;
+  double start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+// Drops every recorded event.
+void traceReset();
+// Events recorded since the last traceReset(), as a Chrome trace JSON document.
+std::string traceToJson();
+bool traceWriteFile(const char* path);
+
+#else
+#define TRACE_SCOPE(name) ((void) 0)
+#endif
@@ -1,21 +1,43 @@
 #include "Utils.h"
+#include "Trace.h"
+#include "Macros.h"
 
-// Precompute log(k!) using log(k!) = log((k-1)!) + log(k)
-// Because nobody wants to compute factorials the hard way
-std::vector<double> precomputeLogFactorials(int n) {
-  std::vector<double> logFact(n + 1);
-  logFact[0] = 0.0;
-  for (int i = 1; i <= n; ++i) {
-    logFact[i] = logFact[i - 1] + std::log(static_cast<double>(i));
-  }
-  return logFact;
+// log(k!), from a table of LOG_FACTORIAL_TABLE entries built once on first use
+// (log(k!) = log((k-1)!) + log(k)) and shared by every solver and thread, and from
+// lgamma past its end.
+double logFactorial(int k) {
+  static const std::vector<double> table = [] {
+    std::vector<double> logFact(LOG_FACTORIAL_TABLE);
+    logFact[0] = 0.0;
+    for (int i = 1; i < LOG_FACTORIAL_TABLE; ++i)
+      logFact[i] = logFact[i - 1] + std::log(static_cast<double>(i));
+    return logFact;
+  }();
+  if (k < LOG_FACTORIAL_TABLE)
+    return table[k];
+  return std::lgamma(k + 1.0);
+}
+
+// Scales counts by a power of two so that the largest is in [0.5, 1), which is
+// exact, and returns the exponent taken out (0 if every count is zero).
+int normalizeCounts(std::vector<double>& counts) {
+  double top = 0;
+  for (double v : counts)
+    top = std::max(top, v);
+  if (top == 0)
+    return 0;
+  int exponent;
+  std::frexp(top, &exponent);
+  for (double& v : counts)
+    v = std::ldexp(v, -exponent);
+  return exponent;
 }
 
-// log(C(n, r)) = log(n!) - log(r!) - log((n-r)!)
+// log(weight * C(n, r)) = log(weight) + log(n!) - log(r!) - log((n-r)!)
 // Math: making the impossible merely improbable since forever
-double logBinomialWithWeight(int n, int r, const std::vector<double>& logFact, int weight) {
-  if (r < 0 || r > n) return -std::numeric_limits<double>::infinity();
-  return std::log(static_cast<double>(weight)) + logFact[n] - logFact[r] - logFact[n - r];
+double logBinomialWithWeight(int n, int r, double weight) {
+  if (r < 0 || r > n || weight <= 0) return -std::numeric_limits<double>::infinity();
+  return std::log(weight) + logFactorial(n) - logFactorial(r) - logFactorial(n - r);
 }
 
 // The log-sum-exp trick: because naive summation of exp() is for people
@@ -33,20 +55,18 @@ double logSumExp(const std::vector<double>& logValues) {
   return maxVal + std::log(sum);
 }
 
-std::vector<double> computeNormalizedBinomials(int n, const std::vector<int>& R, const std::vector<int>& weights) {
-  // Step 1: Precompute log factorials (O(n) time and space)
-  auto logFact = precomputeLogFactorials(n);
-
-  // Step 2: Compute log(C(n, r_i)) for each r_i
+std::vector<double> computeNormalizedBinomials(int n, const std::vector<int>& R, const std::vector<double>& weights) {
+  TRACE_SCOPE("computeNormalizedBinomials");
+  // Step 1: Compute log(w_i * C(n, r_i)) for each r_i
   std::vector<double> logC(R.size());
   for (size_t i = 0; i < R.size(); ++i) {
-    logC[i] = logBinomialWithWeight(n, R[i], logFact, weights[i]);
+    logC[i] = logBinomialWithWeight(n, R[i], weights[i]);
   }
 
-  // Step 3: Compute log(sum(C(n, r_j))) using log-sum-exp
+  // Step 2: Compute log(sum(w_j * C(n, r_j))) using log-sum-exp
   double logSum = logSumExp(logC);
 
-  // Step 4: Compute ratios: c_i / sum = exp(log(c_i) - log(sum))
+  // Step 3: Compute ratios: c_i / sum = exp(log(c_i) - log(sum))
   std::vector<double> ratios(R.size());
   for (size_t i = 0; i < R.size(); ++i) {
     ratios[i] = std::exp(logC[i] - logSum);
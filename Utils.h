@@ -5,5 +5,11 @@
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
+#include <limits>
 
-std::vector<double> computeNormalizedBinomials(int n, const std::vector<int>& R, const std::vector<int>& weights);
\ No newline at end of file
+// log(k!) for k >= 0
+double logFactorial(int k);
+// Scales counts (configuration counts relative to a power of two) so that the
+// largest is in [0.5, 1), and returns the exponent taken out
+int normalizeCounts(std::vector<double>& counts);
+std::vector<double> computeNormalizedBinomials(int n, const std::vector<int>& R, const std::vector<double>& weights);
\ No newline at end of file